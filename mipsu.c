@@ -12,13 +12,31 @@
  * Copyright (c) 2026 mxwll013
  */
 
+#define _DEFAULT_SOURCE
+
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#ifndef MIPSU_LIB
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
 
-#define MIPSU_VERSION "1.0.1"
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "mipsu.h"
 
 #define true  1
 #define false 0
@@ -26,25 +44,56 @@
 typedef int  bool_t;
 typedef FILE file_t;
 
-typedef uint32_t               mipsu_word_t;
-typedef enum mipsu_type        mipsu_type_t;
 typedef enum mipsu_op_fmt      mipsu_op_fmt_t;
 typedef struct mipsu_op_entry  mipsu_op_entry_t;
 typedef struct mipsu_reg_entry mipsu_reg_entry_t;
-typedef struct mipsu_field     mipsu_field_t;
 
 typedef enum mipsu_exit         mipsu_exit_t;
-typedef enum mipsu_result       mipsu_result_t;
-typedef enum mipsu_flag         mipsu_flag_t;
 typedef struct mipsu_flag_entry mipsu_flag_entry_t;
+typedef struct mipsu_buff       mipsu_buff_t;
+typedef struct mipsu_cli        mipsu_cli_t;
 typedef struct mipsu_cmd        mipsu_cmd_t;
-typedef struct mipsu_ctx        mipsu_ctx_t;
-
-enum mipsu_type {
-    MIPSU_TYPE_R,
-    MIPSU_TYPE_I,
-    MIPSU_TYPE_J,
-};
+typedef struct mipsu_map        mipsu_map_t;
+typedef struct mipsu_src        mipsu_src_t;
+typedef struct mipsu_stream     mipsu_stream_t;
+typedef struct mipsu_span       mipsu_span_t;
+typedef struct mipsu_lex        mipsu_lex_t;
+typedef struct mipsu_hexin      mipsu_hexin_t;
+typedef struct mipsu_bench      mipsu_bench_t;
+typedef struct mipsu_bench_path mipsu_bench_path_t;
+typedef struct mipsu_sweep      mipsu_sweep_t;
+typedef struct mipsu_cache      mipsu_cache_t;
+typedef struct mipsu_cfg        mipsu_cfg_t;
+typedef struct mipsu_lat        mipsu_lat_t;
+typedef struct mipsu_timing     mipsu_timing_t;
+typedef struct mipsu_job        mipsu_job_t;
+
+typedef struct mipsu_elf_hdr  mipsu_elf_hdr_t;
+typedef struct mipsu_elf_shdr mipsu_elf_shdr_t;
+typedef struct mipsu_elf_phdr mipsu_elf_phdr_t;
+typedef struct mipsu_elf_sym  mipsu_elf_sym_t;
+typedef struct mipsu_sym      mipsu_sym_t;
+typedef struct mipsu_elf      mipsu_elf_t;
+
+typedef enum mipsu_fix      mipsu_fix_t;
+typedef struct mipsu_words  mipsu_words_t;
+typedef struct mipsu_label  mipsu_label_t;
+typedef struct mipsu_fixup  mipsu_fixup_t;
+typedef struct mipsu_unit   mipsu_unit_t;
+
+typedef struct mipsu_mem      mipsu_mem_t;
+typedef struct mipsu_block    mipsu_block_t;
+typedef struct mipsu_pre      mipsu_pre_t;
+typedef struct mipsu_cpu      mipsu_cpu_t;
+typedef struct mipsu_snap     mipsu_snap_t;
+typedef struct mipsu_snap_hdr mipsu_snap_hdr_t;
+typedef struct mipsu_case     mipsu_case_t;
+typedef struct mipsu_image    mipsu_image_t;
+typedef struct mipsu_pool     mipsu_pool_t;
+typedef struct mipsu_prof     mipsu_prof_t;
+
+typedef void (*mipsu_exec_t)(mipsu_cpu_t*, const mipsu_pre_t*);
+typedef void (*mipsu_sys_t)(mipsu_cpu_t*);
 
 enum mipsu_op_fmt {
     MIPSU_OP_FMT_UNKNOWN,
@@ -53,6 +102,7 @@ enum mipsu_op_fmt {
     MIPSU_OP_FMT_RS,
     MIPSU_OP_FMT_RD,
     MIPSU_OP_FMT_RS_RT,
+    MIPSU_OP_FMT_RD_RS,
     MIPSU_OP_FMT_RD_RS_RT,
     MIPSU_OP_FMT_RD_RT_RS,
     MIPSU_OP_FMT_RD_RT_SH,
@@ -66,58 +116,39 @@ enum mipsu_op_fmt {
     MIPSU_OP_FMT_ADDR,
 };
 
+/* register operands, bit per field; RA is the implicit $ra of jal */
+enum mipsu_role {
+    MIPSU_ROLE_RS = 1 << 0,
+    MIPSU_ROLE_RT = 1 << 1,
+    MIPSU_ROLE_RD = 1 << 2,
+    MIPSU_ROLE_RA = 1 << 3,
+};
+
+/* the CLI's own flags, above the library's */
+enum mipsu_cli_flag {
+    MIPSU_FLAG_VERBOSE  = 1 << 4,
+    MIPSU_FLAG_NO_COLOR = 1 << 5,
+    MIPSU_FLAG_RAW      = 1 << 6,
+    MIPSU_FLAG_ELF      = 1 << 7,
+    MIPSU_FLAG_BE       = 1 << 8,
+    MIPSU_FLAG_LE       = 1 << 9,
+    MIPSU_FLAG_HEXDUMP  = 1 << 10,
+    MIPSU_FLAG_JSONL    = 1 << 11,
+    MIPSU_FLAG_BIN      = 1 << 12,
+    MIPSU_FLAG_DIFF     = 1 << 13,
+    MIPSU_FLAG_LABELS   = 1 << 14,
+    MIPSU_FLAG_RESUME   = 1 << 15,
+    MIPSU_FLAG_ANNOTATE = 1 << 16,
+    MIPSU_FLAG_HOST_FS  = 1 << 17,
+};
+
 enum mipsu_exit {
     MIPSU_EXIT_OK,
 
     MIPSU_EXIT_USAGE,
     MIPSU_EXIT_PARSE,
     MIPSU_EXIT_INTERNAL,
-};
-
-enum mipsu_result {
-    MIPSU_RESULT_OK,
-
-    MIPSU_RESULT_BAD_CMD,
-    MIPSU_RESULT_BAD_ARGC,
-    MIPSU_RESULT_MISSING_ARGS,
-    MIPSU_RESULT_TOO_MANY_ARGS,
-    MIPSU_RESULT_FROM_FILE,
-    MIPSU_RESULT_RAW_STDIN,
-    MIPSU_RESULT_RAW_STDOUT,
-    MIPSU_RESULT_STDIN_CHAR,
-
-    MIPSU_RESULT_BAD_DEC,
-    MIPSU_RESULT_BAD_RADIX,
-    MIPSU_RESULT_BAD_HEX,
-    MIPSU_RESULT_MISSING_HEXITS,
-    MIPSU_RESULT_TOO_MANY_HEXITS,
-    MIPSU_RESULT_BAD_BIN,
-    MIPSU_RESULT_MISSING_BITS,
-    MIPSU_RESULT_TOO_MANY_BITS,
-    MIPSU_RESULT_BAD_OP,
-    MIPSU_RESULT_BAD_OP_FMT,
-    MIPSU_RESULT_BAD_OP_TYPE,
-    MIPSU_RESULT_BAD_INSTR,
-    MIPSU_RESULT_BAD_FN,
-    MIPSU_RESULT_BAD_REG,
-    MIPSU_RESULT_FIELD_OVERFLOW,
-    MIPSU_RESULT_FIELD_SIGN,
-    MIPSU_RESULT_SKIPPED,
-    MIPSU_RESULT_INSTR_SIZE,
-
-    MIPSU_RESULT_BUFF_OVERFLOW,
-    MIPSU_RESULT_READ_FILE,
-    MIPSU_RESULT_OPEN_FILE,
-};
-
-enum mipsu_flag {
-    MIPSU_FLAG_QUIET    = 1 << 0,
-    MIPSU_FLAG_VERBOSE  = 1 << 1,
-    MIPSU_FLAG_NO_COLOR = 1 << 2,
-    MIPSU_FLAG_NREG     = 1 << 3,
-    MIPSU_FLAG_DIMM     = 1 << 4,
-    MIPSU_FLAG_STRICT   = 1 << 5,
-    MIPSU_FLAG_RAW      = 1 << 6,
+    MIPSU_EXIT_EMU,
 };
 
 struct mipsu_reg_entry {
@@ -127,49 +158,462 @@ struct mipsu_reg_entry {
 
 struct mipsu_op_entry {
     const char*    mnem;
+    uint8_t        len;
     mipsu_op_fmt_t fmt;
     mipsu_type_t   type;
+    uint8_t        use;
+    uint8_t        def;
+};
+
+struct mipsu_flag_entry {
+    const char* name;
+    uint32_t    bit;
+    char        shrt;
+};
+
+/* lost counts bytes dropped for want of room, with no stream to flush to */
+struct mipsu_buff {
+    char*  data;
+    size_t n;
+    size_t cap;
+    size_t lost;
+};
+
+/*
+ * The CLI's context: the library's flags and its own, then the streams,
+ * output buffer, job count, profile path, cache directory and batch file.
+ */
+struct mipsu_cli {
+    uint32_t      flags;
+    file_t*       o;
+    file_t*       f;
+    mipsu_buff_t* b;
+    size_t        jobs;
+    const char*   prof;
+    const char*   cache;
+    const char*   batch;
 };
 
-struct mipsu_field {
-    mipsu_type_t type;
-    uint8_t      op;
-    union {
+struct mipsu_cmd {
+    const char* name;
+    mipsu_result_t (*from_file)(mipsu_cli_t c);
+    mipsu_result_t (*from_arg)(const char*, mipsu_cli_t c);
+    mipsu_result_t (*from_args)(size_t, const char**, mipsu_cli_t c);
+};
 
-        struct {
-            uint8_t rs, rt;
+struct mipsu_map {
+    const void* data;
+    size_t      size;
+};
 
-            union {
-                struct {
-                    uint8_t rd, sh, fn;
-                };
-                struct {
-                    int16_t imm;
-                };
-            };
-        };
+/* a whole source file, writable and followed by a zero byte */
+struct mipsu_src {
+    char*  data;
+    size_t size;
+    bool_t heap;
+};
 
-        uint32_t addr;
-    };
+/*
+ * Raw input a block at a time. Files are mapped a window at a time, z bytes
+ * in all, o of them done. Pipes are read two blocks at a time: b[cur] is
+ * worked on while a thread reads the next block into the other. fread waits
+ * for a whole block, so only the last can be short, or end in part of a
+ * word; rest is the bytes of that part.
+ */
+struct mipsu_stream {
+    file_t*     f;
+    mipsu_map_t m;
+    size_t      o;
+    size_t      z;
+    bool_t      pipe;
+    uint8_t*    b[2];
+    size_t      n[2];
+    bool_t      cur;
+    bool_t      busy;
+    bool_t      done;
+    size_t      rest;
+    pthread_t   t;
 };
 
-struct mipsu_flag_entry {
-    const char*  name;
-    mipsu_flag_t bit;
-    char         shrt;
+struct mipsu_span {
+    char*  s;
+    size_t n;
 };
 
-struct mipsu_cmd {
+/* a source buffer read a line at a time, e one past its last byte */
+struct mipsu_lex {
+    char* p;
+    char* e;
+};
+
+/* hex dump words staged for disasm, and the hexits of one not yet whole */
+struct mipsu_hexin {
+    mipsu_word_t  w[1 << 10];
+    size_t        n;
+    uint32_t      a;
+    mipsu_word_t  v;
+    size_t        k;
+    mipsu_prof_t* f;
+};
+
+/* a corpus, as words, decoded fields and disasm lines a stride apart */
+struct mipsu_bench {
+    mipsu_word_t*  w;
+    mipsu_field_t* f;
+    char*          t;
+    size_t         n;
+    size_t         sink;
+};
+
+struct mipsu_bench_path {
+    const char* name;
+    void (*run)(mipsu_bench_t* b, mipsu_cli_t c);
+};
+
+/*
+ * A sweep thread, taking every step-th chunk of [lo, hi) from its first.
+ * n counts canonical, non-canonical and unknown words; per instruction,
+ * used ORs its canonical words and miss counts the words mipsu_verify
+ * judges otherwise. live is whether t started, as for mipsu_job.
+ */
+struct mipsu_sweep {
+    pthread_t    t;
+    bool_t       live;
+    mipsu_ctx_t  c;
+    uint64_t     lo, hi;
+    size_t       first, step;
+    uint64_t     n[3];
+    uint64_t     canon[128];
+    uint64_t     miss[128];
+    mipsu_word_t used[128];
+};
+
+/*
+ * Listings of pages kept in a directory, one file per page named by its
+ * key: the page's words, then its listing. path holds the directory and a
+ * '/', n long, then room for a key; b is a page's listing.
+ */
+struct mipsu_cache {
+    char*        path;
+    char*        tmp;
+    size_t       n;
+    mipsu_buff_t b;
+};
+
+/*
+ * Control flow of n words of text at a. t holds the targets of branches
+ * and jumps that land in it, l the block leaders: the first word, every
+ * target and every word after a delay slot. Both are sorted and unique.
+ */
+struct mipsu_cfg {
+    const mipsu_word_t* w;
+    size_t              n;
+    uint32_t            a;
+    uint32_t*           t;
+    size_t              tn;
+    uint32_t*           l;
+    size_t              ln;
+};
+
+/* cycles after issue that results and operands lag, for one flavour */
+struct mipsu_lat {
+    const char* name;
+    uint32_t    load;
+    uint32_t    mult, div;
+    uint32_t    branch;
+};
+
+/*
+ * Timing state: the cycle each register, then HI and LO, is ready at, and
+ * the cycle the next word issues at, from the start of its block; then
+ * totals over every block timed.
+ */
+struct mipsu_timing {
+    uint32_t ready[33];
+    uint32_t t;
+    uint64_t blocks, words, stalls, slots;
+};
+
+/* ELF32 as laid out on disk, naturally aligned and so without padding */
+struct mipsu_elf_hdr {
+    uint8_t  ident[16];
+    uint16_t type, machine;
+    uint32_t version, entry, phoff, shoff, flags;
+    uint16_t ehsize, phentsize, phnum, shentsize, shnum, shstrndx;
+};
+
+struct mipsu_elf_shdr {
+    uint32_t name, type, flags, addr, off, size, link, info, align, entsize;
+};
+
+struct mipsu_elf_phdr {
+    uint32_t type, off, vaddr, paddr, filesz, memsz, flags, align;
+};
+
+struct mipsu_elf_sym {
+    uint32_t name, value, size;
+    uint8_t  info, other;
+    uint16_t shndx;
+};
+
+struct mipsu_sym {
+    uint32_t    addr;
+    uint16_t    shndx;
     const char* name;
-    mipsu_result_t (*from_file)(mipsu_ctx_t c);
-    mipsu_result_t (*from_arg)(const char*, mipsu_ctx_t c);
-    mipsu_result_t (*from_args)(size_t, const char**, mipsu_ctx_t c);
 };
 
-struct mipsu_ctx {
-    mipsu_flag_t flags;
-    file_t*      o;
-    file_t*      f;
+/* how a label reference is patched into its word once the label is known */
+enum mipsu_fix {
+    MIPSU_FIX_BRANCH,
+    MIPSU_FIX_JUMP,
+    MIPSU_FIX_HI,
+    MIPSU_FIX_LO,
+    MIPSU_FIX_WORD,
+};
+
+struct mipsu_words {
+    mipsu_word_t* w;
+    size_t        n;
+    size_t        cap;
+};
+
+/* sect is mipsu_sects while only referenced; off is in bytes */
+struct mipsu_label {
+    size_t   name;
+    size_t   len;
+    uint32_t off;
+    uint8_t  sect;
+};
+
+struct mipsu_fixup {
+    uint32_t    off;
+    uint32_t    label;
+    uint8_t     sect;
+    mipsu_fix_t fix;
+};
+
+/*
+ * An assembly file: words per section, labels in an open addressing table
+ * of label index + 1, and the references still to be patched.
+ */
+struct mipsu_unit {
+    mipsu_words_t  sects[2];
+    uint32_t       align;
+    uint8_t        cur;
+    mipsu_label_t* labels;
+    size_t         labelc, labelcap;
+    uint32_t*      slots;
+    uint8_t        bits;
+    char*          names;
+    size_t         namen, namecap;
+    mipsu_fixup_t* fixups;
+    size_t         fixupc, fixupcap;
+};
+
+/* a mapped ELF file, its symbols sorted by address */
+struct mipsu_elf {
+    mipsu_map_t     map;
+    mipsu_elf_hdr_t h;
+    mipsu_sym_t*    syms;
+    size_t          symc;
+    bool_t          swap;
+};
+
+/* live is whether t started; a job whose thread could not start ran inline */
+struct mipsu_job {
+    pthread_t           t;
+    bool_t              live;
+    const mipsu_word_t* w;
+    size_t              n;
+    uint32_t            a;
+    mipsu_buff_t        b;
+    mipsu_cli_t         c;
+    mipsu_stats_t       s;
+};
+
+/*
+ * Guest memory: a directory of 1024 tables of 1024 pages of 4 KiB. Tables
+ * and pages come from calloc'ed arena chunks on first touch, so only what
+ * is used gets resident; tag and page cache the last page looked up.
+ */
+struct mipsu_mem {
+    uint8_t** dir[1 << 10];
+
+    /* direct mapped page caches, the one for stores never holding text */
+    uint32_t tag[1 << 4], wtag[1 << 4];
+    uint8_t* page[1 << 4];
+    uint8_t* wpage[1 << 4];
+
+    /* a bit per page, set pages never being cached; NULL unless debugging */
+    uint32_t* watch;
+
+    /*
+     * A bit per page lent by a snapshot, copied on its first store; NULL
+     * without one. Pages copied or first mapped since are listed in dirty,
+     * for restore to give back to spare, a list linked through the pages.
+     */
+    uint32_t* lent;
+    uint32_t* dirty;
+    size_t    dirtyc, dirtycap;
+    uint8_t*  spare;
+
+    uint8_t*  next;
+    size_t    left;
+    uint8_t** chunks;
+    size_t    chunkc;
+};
+
+/* a text word decoded once: handler index, registers, and imm or sh */
+struct mipsu_pre {
+    uint8_t h;
+    uint8_t rs, rt, rd;
+    int32_t imm;
+};
+
+/*
+ * A run of text up to and including a branch and its delay slot. tail is
+ * how many of the last words run with pc and npc kept: 2 for a branch and
+ * its delay slot, 1 for a branch ending text, 0 for no branch. link keeps
+ * the successors last taken, so hot loops chain without a lookup; dropped
+ * blocks get an unaligned pc, so links to them never match again. hits
+ * counts complete runs and taken those leaving through the branch; next
+ * lists every block built, dropped or not, for the profile.
+ */
+struct mipsu_block {
+    uint32_t           pc;
+    uint32_t           n;
+    uint32_t           tail;
+    const mipsu_pre_t* i;
+    mipsu_block_t*     link[2];
+    uint64_t           hits, taken;
+    mipsu_block_t*     next;
+};
+
+/*
+ * Execution counts per text word, and per dynamic mnemonic. Annotating
+ * reads words in text order, k being the next one.
+ */
+struct mipsu_prof {
+    uint64_t* hits;
+    uint64_t* taken;
+    uint64_t  instr[128];
+    uint64_t  n;
+    size_t    words;
+    size_t    k;
+};
+
+/*
+ * Emulator state to return to: registers, and every mapped page by number,
+ * sorted. Its pages are lent to the emulator and never stored to through
+ * it; taken in the emulator they live in its arena, loaded from a file they
+ * are mapped from it, along with text already decoded.
+ */
+struct mipsu_snap {
+    uint32_t r[32];
+    uint32_t hi, lo;
+    uint32_t pc, npc, cur;
+    uint32_t brk, text;
+    int32_t  code;
+    uint64_t n;
+
+    uint32_t*          t;
+    uint8_t**          p;
+    size_t             pn;
+    const mipsu_pre_t* pre;
+    mipsu_map_t        map;
+};
+
+/*
+ * A snapshot file, in host byte order: this header, the page numbers, the
+ * decoded text, then the pages from the next page boundary on.
+ */
+struct mipsu_snap_hdr {
+    char     magic[8];
+    uint32_t version;
+    uint32_t pages;
+    uint32_t r[32];
+    uint32_t hi, lo;
+    uint32_t pc, npc, cur;
+    uint32_t brk, text;
+    int32_t  code;
+    uint64_t n;
+};
+
+struct mipsu_cpu {
+    uint32_t r[32];
+    uint32_t hi, lo;
+    uint32_t pc, npc, cur;
+
+    mipsu_mem_t     mem;
+    mipsu_pre_t*    pre;
+    mipsu_block_t** blocks;
+    mipsu_block_t*  all;
+    uint32_t        text;
+
+    /* the block the run stopped in, and how many of its words ran */
+    mipsu_block_t* last;
+    uint32_t       lastn;
+
+    /* a breakpoint bit per text word, NULL unless debugging; words watched */
+    uint64_t* bp;
+    uint32_t  watchv[16];
+    uint32_t  watchc;
+    uint32_t  hit;
+    bool_t    broke, watched;
+
+    /* text offsets stored to since the last block, re-decoded after it */
+    bool_t   dirty;
+    uint32_t dlo, dhi;
+
+    /* guest output goes through c.b, input comes from in; guest fd k + 3 is
+     * host fd files[k] - 1 */
+    mipsu_cli_t c;
+    file_t*     in;
+    uint32_t    brk;
+    int         files[16];
+
+    /* where restore goes back to, while mem.lent is set */
+    mipsu_snap_t snap;
+
+    uint64_t       n;
+    bool_t         run;
+    int32_t        code;
+    mipsu_result_t res;
+};
+
+/*
+ * One manifest line: the text to run, the file it reads as stdin and the
+ * file its stdout must match, "-" for none. The rest is filled in by the
+ * worker that runs it.
+ */
+struct mipsu_case {
+    const char*    bin;
+    const char*    in;
+    const char*    out;
+    size_t         img;
+    mipsu_result_t res;
+    int32_t        code;
+    uint64_t       n;
+};
+
+/* text and its decoding or a snapshot, loaded once, only read by runs */
+struct mipsu_image {
+    mipsu_map_t    t;
+    mipsu_word_t*  w;
+    size_t         n;
+    mipsu_pre_t*   pre;
+    mipsu_snap_t   snap;
+    mipsu_result_t res;
+};
+
+/* workers take the next case under the lock, so long runs even out */
+struct mipsu_pool {
+    mipsu_case_t*        v;
+    size_t               n;
+    size_t               next;
+    const mipsu_image_t* imgs;
+    mipsu_cli_t          c;
+    pthread_mutex_t      lock;
 };
 
 static const mipsu_reg_entry_t mipsu_reg_lut[] = {
@@ -185,99 +629,287 @@ static const mipsu_reg_entry_t mipsu_reg_lut[] = {
     [27] = {"k1", "27"}, [28] = {"gp", "28"}, [29] = {"sp", "29"},
     [30] = {"fp", "30"}, [31] = {"ra", "31"},
 };
-static size_t mipsu_regc = sizeof(mipsu_reg_lut) / sizeof(mipsu_reg_entry_t);
-
-static size_t mipsu_fnv[] = {
-    0x00, 0x02, 0x03, 0x04, 0x06, 0x07, 0x08, 0x09, 0x0C, 0x0D,
-    0x10, 0x11, 0x12, 0x13, 0x18, 0x19, 0x1A, 0x1B, 0x20, 0x21,
-    0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x2A, 0x2B,
-};
-
-static size_t mipsu_opv[] = {
-    0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0C, 0x0D,
-    0x0F, 0x20, 0x21, 0x23, 0x24, 0x25, 0x28, 0x29, 0x2B,
-};
-
-static size_t mipsu_fnc = sizeof(mipsu_fnv) / sizeof(size_t);
-static size_t mipsu_opc = sizeof(mipsu_opv) / sizeof(size_t);
-
-static const mipsu_op_entry_t mipsu_fn_lut[64] = {
+static const size_t mipsu_regc =
+    sizeof(mipsu_reg_lut) / sizeof(mipsu_reg_entry_t);
+
+#define MIPSU_ROLES_NONE  0
+#define MIPSU_ROLES_RS    MIPSU_ROLE_RS
+#define MIPSU_ROLES_RT    MIPSU_ROLE_RT
+#define MIPSU_ROLES_RD    MIPSU_ROLE_RD
+#define MIPSU_ROLES_RA    MIPSU_ROLE_RA
+#define MIPSU_ROLES_RS_RT (MIPSU_ROLE_RS | MIPSU_ROLE_RT)
+
+/* u and d name the registers the instruction reads and writes */
+#define MIPSU_INSTR(m, f, t, u, d)                                             \
+    {m, sizeof(m) - 1, MIPSU_OP_FMT_##f, MIPSU_TYPE_##t, MIPSU_ROLES_##u,      \
+     MIPSU_ROLES_##d}
+
+/* R-type entries are indexed by fn, everything else by 64 + op */
+#define MIPSU_FN(fn) (fn)
+#define MIPSU_OP(op) (0x40 | (op))
+
+static const mipsu_op_entry_t mipsu_instr_lut[128] = {
     /* Shift */
-    [0x00] = {"sll", MIPSU_OP_FMT_RD_RT_SH, MIPSU_TYPE_R},
+    [MIPSU_FN(0x00)] = MIPSU_INSTR("sll", RD_RT_SH, R, RT, RD),
 
-    [0x02] = {"srl", MIPSU_OP_FMT_RD_RT_SH, MIPSU_TYPE_R},
-    [0x03] = {"sra", MIPSU_OP_FMT_RD_RT_SH, MIPSU_TYPE_R},
-    [0x04] = {"sllv", MIPSU_OP_FMT_RD_RT_RS, MIPSU_TYPE_R},
+    [MIPSU_FN(0x02)] = MIPSU_INSTR("srl", RD_RT_SH, R, RT, RD),
+    [MIPSU_FN(0x03)] = MIPSU_INSTR("sra", RD_RT_SH, R, RT, RD),
+    [MIPSU_FN(0x04)] = MIPSU_INSTR("sllv", RD_RT_RS, R, RS_RT, RD),
 
-    [0x06] = {"srlv", MIPSU_OP_FMT_RD_RT_RS, MIPSU_TYPE_R},
-    [0x07] = {"srav", MIPSU_OP_FMT_RD_RT_RS, MIPSU_TYPE_R},
+    [MIPSU_FN(0x06)] = MIPSU_INSTR("srlv", RD_RT_RS, R, RS_RT, RD),
+    [MIPSU_FN(0x07)] = MIPSU_INSTR("srav", RD_RT_RS, R, RS_RT, RD),
 
     /* Misc */
-    [0x08] = {"jalr", MIPSU_OP_FMT_RS, MIPSU_TYPE_R},
-    [0x09] = {"jr", MIPSU_OP_FMT_RS, MIPSU_TYPE_R},
+    [MIPSU_FN(0x08)] = MIPSU_INSTR("jr", RS, R, RS, NONE),
+    [MIPSU_FN(0x09)] = MIPSU_INSTR("jalr", RD_RS, R, RS, RD),
 
-    [0x0C] = {"syscall", MIPSU_OP_FMT_NONE, MIPSU_TYPE_R},
-    [0x0D] = {"break", MIPSU_OP_FMT_NONE, MIPSU_TYPE_R},
+    [MIPSU_FN(0x0C)] = MIPSU_INSTR("syscall", NONE, R, NONE, NONE),
+    [MIPSU_FN(0x0D)] = MIPSU_INSTR("break", NONE, R, NONE, NONE),
 
     /* MUL */
-    [0x10] = {"mfhi", MIPSU_OP_FMT_RD, MIPSU_TYPE_R},
-    [0x11] = {"mthi", MIPSU_OP_FMT_RS, MIPSU_TYPE_R},
-    [0x12] = {"mflo", MIPSU_OP_FMT_RD, MIPSU_TYPE_R},
-    [0x13] = {"mtlo", MIPSU_OP_FMT_RS, MIPSU_TYPE_R},
+    [MIPSU_FN(0x10)] = MIPSU_INSTR("mfhi", RD, R, NONE, RD),
+    [MIPSU_FN(0x11)] = MIPSU_INSTR("mthi", RS, R, RS, NONE),
+    [MIPSU_FN(0x12)] = MIPSU_INSTR("mflo", RD, R, NONE, RD),
+    [MIPSU_FN(0x13)] = MIPSU_INSTR("mtlo", RS, R, RS, NONE),
 
-    [0x18] = {"mult", MIPSU_OP_FMT_RS_RT, MIPSU_TYPE_R},
-    [0x19] = {"multu", MIPSU_OP_FMT_RS_RT, MIPSU_TYPE_R},
-    [0x1A] = {"div", MIPSU_OP_FMT_RS_RT, MIPSU_TYPE_R},
-    [0x1B] = {"divu", MIPSU_OP_FMT_RS_RT, MIPSU_TYPE_R},
+    [MIPSU_FN(0x18)] = MIPSU_INSTR("mult", RS_RT, R, RS_RT, NONE),
+    [MIPSU_FN(0x19)] = MIPSU_INSTR("multu", RS_RT, R, RS_RT, NONE),
+    [MIPSU_FN(0x1A)] = MIPSU_INSTR("div", RS_RT, R, RS_RT, NONE),
+    [MIPSU_FN(0x1B)] = MIPSU_INSTR("divu", RS_RT, R, RS_RT, NONE),
 
     /* ALU */
-    [0x20] = {"add", MIPSU_OP_FMT_RD_RS_RT, MIPSU_TYPE_R},
-    [0x21] = {"addu", MIPSU_OP_FMT_RD_RS_RT, MIPSU_TYPE_R},
-    [0x22] = {"sub", MIPSU_OP_FMT_RD_RS_RT, MIPSU_TYPE_R},
-    [0x23] = {"subu", MIPSU_OP_FMT_RD_RS_RT, MIPSU_TYPE_R},
-    [0x24] = {"and", MIPSU_OP_FMT_RD_RS_RT, MIPSU_TYPE_R},
-    [0x25] = {"or", MIPSU_OP_FMT_RD_RS_RT, MIPSU_TYPE_R},
-    [0x26] = {"xor", MIPSU_OP_FMT_RD_RS_RT, MIPSU_TYPE_R},
-    [0x27] = {"nor", MIPSU_OP_FMT_RD_RS_RT, MIPSU_TYPE_R},
-
-    [0x2A] = {"slt", MIPSU_OP_FMT_RD_RS_RT, MIPSU_TYPE_R},
-    [0x2B] = {"sltu", MIPSU_OP_FMT_RD_RS_RT, MIPSU_TYPE_R},
-};
+    [MIPSU_FN(0x20)] = MIPSU_INSTR("add", RD_RS_RT, R, RS_RT, RD),
+    [MIPSU_FN(0x21)] = MIPSU_INSTR("addu", RD_RS_RT, R, RS_RT, RD),
+    [MIPSU_FN(0x22)] = MIPSU_INSTR("sub", RD_RS_RT, R, RS_RT, RD),
+    [MIPSU_FN(0x23)] = MIPSU_INSTR("subu", RD_RS_RT, R, RS_RT, RD),
+    [MIPSU_FN(0x24)] = MIPSU_INSTR("and", RD_RS_RT, R, RS_RT, RD),
+    [MIPSU_FN(0x25)] = MIPSU_INSTR("or", RD_RS_RT, R, RS_RT, RD),
+    [MIPSU_FN(0x26)] = MIPSU_INSTR("xor", RD_RS_RT, R, RS_RT, RD),
+    [MIPSU_FN(0x27)] = MIPSU_INSTR("nor", RD_RS_RT, R, RS_RT, RD),
+
+    [MIPSU_FN(0x2A)] = MIPSU_INSTR("slt", RD_RS_RT, R, RS_RT, RD),
+    [MIPSU_FN(0x2B)] = MIPSU_INSTR("sltu", RD_RS_RT, R, RS_RT, RD),
 
-static const mipsu_op_entry_t mipsu_op_lut[64] = {
     /* Type R */
-    [0x00] = {"", MIPSU_OP_FMT_NONE, MIPSU_TYPE_R},
+    [MIPSU_OP(0x00)] = MIPSU_INSTR("", NONE, R, NONE, NONE),
 
     /* Jump */
-    [0x02] = {"j", MIPSU_OP_FMT_ADDR, MIPSU_TYPE_J},
-    [0x03] = {"jal", MIPSU_OP_FMT_ADDR, MIPSU_TYPE_J},
+    [MIPSU_OP(0x02)] = MIPSU_INSTR("j", ADDR, J, NONE, NONE),
+    [MIPSU_OP(0x03)] = MIPSU_INSTR("jal", ADDR, J, NONE, RA),
 
     /* Branch */
-    [0x04] = {"beq", MIPSU_OP_FMT_RS_RT_IMM, MIPSU_TYPE_I},
-    [0x05] = {"bne", MIPSU_OP_FMT_RS_RT_IMM, MIPSU_TYPE_I},
-    [0x06] = {"blez", MIPSU_OP_FMT_RS_IMM, MIPSU_TYPE_I},
-    [0x07] = {"bgtz", MIPSU_OP_FMT_RS_IMM, MIPSU_TYPE_I},
+    [MIPSU_OP(0x04)] = MIPSU_INSTR("beq", RS_RT_IMM, I, RS_RT, NONE),
+    [MIPSU_OP(0x05)] = MIPSU_INSTR("bne", RS_RT_IMM, I, RS_RT, NONE),
+    [MIPSU_OP(0x06)] = MIPSU_INSTR("blez", RS_IMM, I, RS, NONE),
+    [MIPSU_OP(0x07)] = MIPSU_INSTR("bgtz", RS_IMM, I, RS, NONE),
 
     /* ALU */
-    [0x08] = {"addi", MIPSU_OP_FMT_RT_RS_IMM, MIPSU_TYPE_I},
-    [0x09] = {"addiu", MIPSU_OP_FMT_RT_RS_IMM, MIPSU_TYPE_I},
-    [0x0C] = {"andi", MIPSU_OP_FMT_RT_RS_IMM, MIPSU_TYPE_I},
-    [0x0D] = {"ori", MIPSU_OP_FMT_RT_RS_IMM, MIPSU_TYPE_I},
-    [0x0F] = {"lui", MIPSU_OP_FMT_RT_IMM, MIPSU_TYPE_I},
+    [MIPSU_OP(0x08)] = MIPSU_INSTR("addi", RT_RS_IMM, I, RS, RT),
+    [MIPSU_OP(0x09)] = MIPSU_INSTR("addiu", RT_RS_IMM, I, RS, RT),
+    [MIPSU_OP(0x0C)] = MIPSU_INSTR("andi", RT_RS_IMM, I, RS, RT),
+    [MIPSU_OP(0x0D)] = MIPSU_INSTR("ori", RT_RS_IMM, I, RS, RT),
+    [MIPSU_OP(0x0F)] = MIPSU_INSTR("lui", RT_IMM, I, NONE, RT),
 
     /* MEM */
-    [0x20] = {"lb", MIPSU_OP_FMT_RT_IMM_RS, MIPSU_TYPE_I},
-    [0x21] = {"lh", MIPSU_OP_FMT_RT_IMM_RS, MIPSU_TYPE_I},
+    [MIPSU_OP(0x20)] = MIPSU_INSTR("lb", RT_IMM_RS, I, RS, RT),
+    [MIPSU_OP(0x21)] = MIPSU_INSTR("lh", RT_IMM_RS, I, RS, RT),
+
+    [MIPSU_OP(0x23)] = MIPSU_INSTR("lw", RT_IMM_RS, I, RS, RT),
+
+    [MIPSU_OP(0x24)] = MIPSU_INSTR("lbu", RT_IMM_RS, I, RS, RT),
+    [MIPSU_OP(0x25)] = MIPSU_INSTR("lhu", RT_IMM_RS, I, RS, RT),
+
+    [MIPSU_OP(0x28)] = MIPSU_INSTR("sb", RT_IMM_RS, I, RS_RT, NONE),
+    [MIPSU_OP(0x29)] = MIPSU_INSTR("sh", RT_IMM_RS, I, RS_RT, NONE),
 
-    [0x23] = {"lw", MIPSU_OP_FMT_RT_IMM_RS, MIPSU_TYPE_I},
+    [MIPSU_OP(0x2B)] = MIPSU_INSTR("sw", RT_IMM_RS, I, RS_RT, NONE),
+};
+
+/*
+ * The bits a canonical encoding may set, by the index of mipsu_instr_lut:
+ * the instruction's own op and fn bits and the fields its syntax shows.
+ * Words setting any other bit are unknown or not canonical. Generated by
+ * 'mipsu sweep', which checks it against all 2^32 words.
+ */
+static const mipsu_word_t mipsu_legal_lut[128] = {
+    [MIPSU_FN(0x00)] = 0x001FFFC0, /* sll */
+    [MIPSU_FN(0x02)] = 0x001FFFC2, /* srl */
+    [MIPSU_FN(0x03)] = 0x001FFFC3, /* sra */
+    [MIPSU_FN(0x04)] = 0x03FFF804, /* sllv */
+    [MIPSU_FN(0x06)] = 0x03FFF806, /* srlv */
+    [MIPSU_FN(0x07)] = 0x03FFF807, /* srav */
+    [MIPSU_FN(0x08)] = 0x03E00008, /* jr */
+    [MIPSU_FN(0x09)] = 0x03E0F809, /* jalr */
+    [MIPSU_FN(0x0C)] = 0x0000000C, /* syscall */
+    [MIPSU_FN(0x0D)] = 0x0000000D, /* break */
+    [MIPSU_FN(0x10)] = 0x0000F810, /* mfhi */
+    [MIPSU_FN(0x11)] = 0x03E00011, /* mthi */
+    [MIPSU_FN(0x12)] = 0x0000F812, /* mflo */
+    [MIPSU_FN(0x13)] = 0x03E00013, /* mtlo */
+    [MIPSU_FN(0x18)] = 0x03FF0018, /* mult */
+    [MIPSU_FN(0x19)] = 0x03FF0019, /* multu */
+    [MIPSU_FN(0x1A)] = 0x03FF001A, /* div */
+    [MIPSU_FN(0x1B)] = 0x03FF001B, /* divu */
+    [MIPSU_FN(0x20)] = 0x03FFF820, /* add */
+    [MIPSU_FN(0x21)] = 0x03FFF821, /* addu */
+    [MIPSU_FN(0x22)] = 0x03FFF822, /* sub */
+    [MIPSU_FN(0x23)] = 0x03FFF823, /* subu */
+    [MIPSU_FN(0x24)] = 0x03FFF824, /* and */
+    [MIPSU_FN(0x25)] = 0x03FFF825, /* or */
+    [MIPSU_FN(0x26)] = 0x03FFF826, /* xor */
+    [MIPSU_FN(0x27)] = 0x03FFF827, /* nor */
+    [MIPSU_FN(0x2A)] = 0x03FFF82A, /* slt */
+    [MIPSU_FN(0x2B)] = 0x03FFF82B, /* sltu */
+    [MIPSU_OP(0x02)] = 0x0BFFFFFF, /* j */
+    [MIPSU_OP(0x03)] = 0x0FFFFFFF, /* jal */
+    [MIPSU_OP(0x04)] = 0x13FFFFFF, /* beq */
+    [MIPSU_OP(0x05)] = 0x17FFFFFF, /* bne */
+    [MIPSU_OP(0x06)] = 0x1BE0FFFF, /* blez */
+    [MIPSU_OP(0x07)] = 0x1FE0FFFF, /* bgtz */
+    [MIPSU_OP(0x08)] = 0x23FFFFFF, /* addi */
+    [MIPSU_OP(0x09)] = 0x27FFFFFF, /* addiu */
+    [MIPSU_OP(0x0C)] = 0x33FFFFFF, /* andi */
+    [MIPSU_OP(0x0D)] = 0x37FFFFFF, /* ori */
+    [MIPSU_OP(0x0F)] = 0x3C1FFFFF, /* lui */
+    [MIPSU_OP(0x20)] = 0x83FFFFFF, /* lb */
+    [MIPSU_OP(0x21)] = 0x87FFFFFF, /* lh */
+    [MIPSU_OP(0x23)] = 0x8FFFFFFF, /* lw */
+    [MIPSU_OP(0x24)] = 0x93FFFFFF, /* lbu */
+    [MIPSU_OP(0x25)] = 0x97FFFFFF, /* lhu */
+    [MIPSU_OP(0x28)] = 0xA3FFFFFF, /* sb */
+    [MIPSU_OP(0x29)] = 0xA7FFFFFF, /* sh */
+    [MIPSU_OP(0x2B)] = 0xAFFFFFFF, /* sw */
+};
+
+static const mipsu_op_entry_t* const mipsu_fn_lut = mipsu_instr_lut;
+static const mipsu_op_entry_t* const mipsu_op_lut = mipsu_instr_lut + 0x40;
 
-    [0x24] = {"lbu", MIPSU_OP_FMT_RT_IMM_RS, MIPSU_TYPE_I},
-    [0x25] = {"lhu", MIPSU_OP_FMT_RT_IMM_RS, MIPSU_TYPE_I},
+static const mipsu_op_entry_t mipsu_word_entry =
+    MIPSU_INSTR(".word", UNKNOWN, I, NONE, NONE);
+
+/*
+ * Operand templates, one per format. Lowercase register codes are padded
+ * to the register width; everything that is not a code is copied as is.
+ *
+ *   s t d  rs rt rd    S  rs, unpadded    h  sh
+ *   i      imm         o  imm, always hex a  addr    w  whole word
+ */
+static const char* mipsu_tmpl_lut[] = {
+    [MIPSU_OP_FMT_UNKNOWN] = " w",
+    [MIPSU_OP_FMT_NONE]    = "",
+
+    [MIPSU_OP_FMT_RS]       = " s",
+    [MIPSU_OP_FMT_RD]       = " d",
+    [MIPSU_OP_FMT_RS_RT]    = " s, t",
+    [MIPSU_OP_FMT_RD_RS]    = " d, s",
+    [MIPSU_OP_FMT_RD_RS_RT] = " d, s, t",
+    [MIPSU_OP_FMT_RD_RT_RS] = " d, t, s",
+    [MIPSU_OP_FMT_RD_RT_SH] = " d, t, h",
+
+    [MIPSU_OP_FMT_RS_IMM]    = " s, i",
+    [MIPSU_OP_FMT_RT_IMM]    = " t, i",
+    [MIPSU_OP_FMT_RT_IMM_RS] = " t, o( S )",
+    [MIPSU_OP_FMT_RT_RS_IMM] = " t, s, i",
+    [MIPSU_OP_FMT_RS_RT_IMM] = " s, t, i",
+
+    [MIPSU_OP_FMT_ADDR] = " a",
+};
 
-    [0x28] = {"sb", MIPSU_OP_FMT_RT_IMM_RS, MIPSU_TYPE_I},
-    [0x29] = {"sh", MIPSU_OP_FMT_RT_IMM_RS, MIPSU_TYPE_I},
+/*
+ * Collision-free hash tables over mnemonics and register names, see
+ * mipsu_hash. The seeds give every key its own slot, which mipsu_hash_check
+ * verifies on every start; new entries need a free slot, or a new seed if
+ * there is none.
+ */
+static const uint32_t mipsu_mnem_seed = 0x9E377B93;
+static const uint32_t mipsu_reg_seed  = 0x9E3779DF;
+
+static const uint8_t mipsu_mnem_bits = 8;
+static const uint8_t mipsu_reg_bits  = 7;
+
+static const mipsu_op_entry_t* const mipsu_mnem_hash_lut[256] = {
+    [0x04] = &mipsu_instr_lut[MIPSU_OP(0x0D)], /* ori */
+    [0x0A] = &mipsu_instr_lut[MIPSU_FN(0x18)], /* mult */
+    [0x0B] = &mipsu_instr_lut[MIPSU_FN(0x24)], /* and */
+    [0x10] = &mipsu_instr_lut[MIPSU_FN(0x10)], /* mfhi */
+    [0x1A] = &mipsu_instr_lut[MIPSU_OP(0x29)], /* sh */
+    [0x1E] = &mipsu_instr_lut[MIPSU_OP(0x20)], /* lb */
+    [0x20] = &mipsu_instr_lut[MIPSU_FN(0x26)], /* xor */
+    [0x25] = &mipsu_instr_lut[MIPSU_FN(0x19)], /* multu */
+    [0x27] = &mipsu_instr_lut[MIPSU_OP(0x25)], /* lhu */
+    [0x2A] = &mipsu_instr_lut[MIPSU_OP(0x2B)], /* sw */
+    [0x37] = &mipsu_instr_lut[MIPSU_OP(0x0C)], /* andi */
+    [0x3A] = &mipsu_instr_lut[MIPSU_FN(0x27)], /* nor */
+    [0x40] = &mipsu_instr_lut[MIPSU_OP(0x0F)], /* lui */
+    [0x44] = &mipsu_instr_lut[MIPSU_OP(0x21)], /* lh */
+    [0x4D] = &mipsu_instr_lut[MIPSU_OP(0x04)], /* beq */
+    [0x4F] = &mipsu_instr_lut[MIPSU_FN(0x22)], /* sub */
+    [0x51] = &mipsu_instr_lut[MIPSU_OP(0x23)], /* lw */
+    [0x56] = &mipsu_instr_lut[MIPSU_FN(0x07)], /* srav */
+    [0x57] = &mipsu_instr_lut[MIPSU_OP(0x08)], /* addi */
+    [0x59] = &mipsu_instr_lut[MIPSU_FN(0x04)], /* sllv */
+    [0x5C] = &mipsu_instr_lut[MIPSU_FN(0x1A)], /* div */
+    [0x5E] = &mipsu_instr_lut[MIPSU_FN(0x21)], /* addu */
+    [0x61] = &mipsu_instr_lut[MIPSU_FN(0x06)], /* srlv */
+    [0x68] = &mipsu_instr_lut[MIPSU_OP(0x06)], /* blez */
+    [0x6A] = &mipsu_instr_lut[MIPSU_OP(0x24)], /* lbu */
+    [0x6E] = &mipsu_instr_lut[MIPSU_FN(0x11)], /* mthi */
+    [0x76] = &mipsu_instr_lut[MIPSU_FN(0x00)], /* sll */
+    [0x77] = &mipsu_instr_lut[MIPSU_OP(0x05)], /* bne */
+    [0x92] = &mipsu_instr_lut[MIPSU_FN(0x12)], /* mflo */
+    [0x9D] = &mipsu_instr_lut[MIPSU_OP(0x03)], /* jal */
+    [0xAE] = &mipsu_instr_lut[MIPSU_FN(0x09)], /* jalr */
+    [0xAF] = &mipsu_instr_lut[MIPSU_OP(0x28)], /* sb */
+    [0xC3] = &mipsu_instr_lut[MIPSU_FN(0x0C)], /* syscall */
+    [0xC6] = &mipsu_instr_lut[MIPSU_FN(0x1B)], /* divu */
+    [0xC9] = &mipsu_instr_lut[MIPSU_FN(0x13)], /* mtlo */
+    [0xCF] = &mipsu_instr_lut[MIPSU_FN(0x0D)], /* break */
+    [0xD3] = &mipsu_instr_lut[MIPSU_FN(0x03)], /* sra */
+    [0xD9] = &mipsu_instr_lut[MIPSU_OP(0x09)], /* addiu */
+    [0xDA] = &mipsu_instr_lut[MIPSU_OP(0x02)], /* j */
+    [0xDE] = &mipsu_instr_lut[MIPSU_FN(0x2A)], /* slt */
+    [0xE1] = &mipsu_instr_lut[MIPSU_FN(0x08)], /* jr */
+    [0xE3] = &mipsu_instr_lut[MIPSU_FN(0x02)], /* srl */
+    [0xEA] = &mipsu_instr_lut[MIPSU_FN(0x23)], /* subu */
+    [0xF8] = &mipsu_instr_lut[MIPSU_FN(0x25)], /* or */
+    [0xFB] = &mipsu_instr_lut[MIPSU_OP(0x07)], /* bgtz */
+    [0xFC] = &mipsu_instr_lut[MIPSU_FN(0x20)], /* add */
+    [0xFD] = &mipsu_instr_lut[MIPSU_FN(0x2B)], /* sltu */
+};
 
-    [0x2B] = {"sw", MIPSU_OP_FMT_RT_IMM_RS, MIPSU_TYPE_I},
+static const mipsu_reg_entry_t* const mipsu_reg_hash_lut[128] = {
+    [0x00] = &mipsu_reg_lut[1], /* at */
+    [0x09] = &mipsu_reg_lut[28], /* gp */
+    [0x15] = &mipsu_reg_lut[0], /* zero */
+    [0x18] = &mipsu_reg_lut[24], /* t8 */
+    [0x19] = &mipsu_reg_lut[31], /* ra */
+    [0x20] = &mipsu_reg_lut[25], /* t9 */
+    [0x31] = &mipsu_reg_lut[21], /* s5 */
+    [0x35] = &mipsu_reg_lut[30], /* fp */
+    [0x37] = &mipsu_reg_lut[12], /* t4 */
+    [0x38] = &mipsu_reg_lut[20], /* s4 */
+    [0x3B] = &mipsu_reg_lut[27], /* k1 */
+    [0x3E] = &mipsu_reg_lut[7], /* a3 */
+    [0x3F] = &mipsu_reg_lut[13], /* t5 */
+    [0x40] = &mipsu_reg_lut[23], /* s7 */
+    [0x43] = &mipsu_reg_lut[26], /* k0 */
+    [0x44] = &mipsu_reg_lut[2], /* v0 */
+    [0x46] = &mipsu_reg_lut[6], /* a2 */
+    [0x47] = &mipsu_reg_lut[14], /* t6 */
+    [0x48] = &mipsu_reg_lut[22], /* s6 */
+    [0x4C] = &mipsu_reg_lut[3], /* v1 */
+    [0x4E] = &mipsu_reg_lut[5], /* a1 */
+    [0x4F] = &mipsu_reg_lut[15], /* t7 */
+    [0x50] = &mipsu_reg_lut[17], /* s1 */
+    [0x56] = &mipsu_reg_lut[4], /* a0 */
+    [0x57] = &mipsu_reg_lut[8], /* t0 */
+    [0x58] = &mipsu_reg_lut[16], /* s0 */
+    [0x5E] = &mipsu_reg_lut[9], /* t1 */
+    [0x60] = &mipsu_reg_lut[19], /* s3 */
+    [0x62] = &mipsu_reg_lut[29], /* sp */
+    [0x66] = &mipsu_reg_lut[10], /* t2 */
+    [0x67] = &mipsu_reg_lut[18], /* s2 */
+    [0x6E] = &mipsu_reg_lut[11], /* t3 */
 };
 
 static const int8_t mipsu_hex_lut[256] = {
@@ -288,18 +920,36 @@ static const int8_t mipsu_hex_lut[256] = {
     ['A'] = 10, ['B'] = 11, ['C'] = 12, ['D'] = 13, ['E'] = 14, ['F'] = 15,
 };
 
+/* character classes for splitting tokens */
+enum {
+    MIPSU_CHR_TOKEN,
+    MIPSU_CHR_SEP,
+    MIPSU_CHR_EOL,
+    MIPSU_CHR_COMMENT,
+};
+
+static const uint8_t mipsu_chr_lut[256] = {
+    [' '] = MIPSU_CHR_SEP,  ['\t'] = MIPSU_CHR_SEP, ['\r'] = MIPSU_CHR_SEP,
+    [','] = MIPSU_CHR_SEP,  ['('] = MIPSU_CHR_SEP,  [')'] = MIPSU_CHR_SEP,
+
+    ['\n'] = MIPSU_CHR_EOL, ['#'] = MIPSU_CHR_COMMENT,
+};
+
 static const char mipsu_type_lut[] = {
     [MIPSU_TYPE_R] = 'R',
     [MIPSU_TYPE_I] = 'I',
     [MIPSU_TYPE_J] = 'J',
 };
 
+#ifndef MIPSU_LIB
 static const char* mipsu_err_msg_lut[] = {
     [MIPSU_EXIT_OK]       = "ok",
     [MIPSU_EXIT_USAGE]    = "usage error",
     [MIPSU_EXIT_PARSE]    = "parse error",
     [MIPSU_EXIT_INTERNAL] = "internal error",
+    [MIPSU_EXIT_EMU]      = "emulation error",
 };
+#endif
 
 static const char* mipsu_res_msg_lut[] = {
     [MIPSU_RESULT_OK] = "ok",
@@ -310,8 +960,9 @@ static const char* mipsu_res_msg_lut[] = {
     [MIPSU_RESULT_TOO_MANY_ARGS] = "too many arguments",
     [MIPSU_RESULT_FROM_FILE]     = "command does not allow reading from file",
     [MIPSU_RESULT_RAW_STDIN]     = "cannot read raw binary from stdin",
-    [MIPSU_RESULT_RAW_STDOUT]    = "cannor write raw binary to stdout",
+    [MIPSU_RESULT_RAW_STDOUT]    = "cannot write raw binary to a terminal",
     [MIPSU_RESULT_STDIN_CHAR]    = "drop '-' to read from stdin",
+    [MIPSU_RESULT_BAD_JOBS]      = "invalid number of jobs",
 
     [MIPSU_RESULT_BAD_DEC]         = "invalid decimal number",
     [MIPSU_RESULT_BAD_RADIX]       = "unknown radix (base)",
@@ -334,8 +985,47 @@ static const char* mipsu_res_msg_lut[] = {
     [MIPSU_RESULT_BUFF_OVERFLOW] = "buffer overflow",
     [MIPSU_RESULT_READ_FILE]     = "failed to read raw binary file",
     [MIPSU_RESULT_OPEN_FILE]     = "failed to open file",
+    [MIPSU_RESULT_MAP_FILE]      = "failed to map file",
+
+    [MIPSU_RESULT_EMU_INSTR]    = "reserved instruction",
+    [MIPSU_RESULT_EMU_ADDR]     = "bad memory address",
+    [MIPSU_RESULT_EMU_PC]       = "pc outside of text",
+    [MIPSU_RESULT_EMU_OVERFLOW] = "integer overflow",
+    [MIPSU_RESULT_EMU_SYSCALL]  = "unsupported syscall",
+    [MIPSU_RESULT_EMU_BREAK]    = "break",
+
+    [MIPSU_RESULT_BAD_PROF] = "malformed or mismatched profile",
+
+    [MIPSU_RESULT_BAD_DEBUG]      = "unknown debugger command",
+    [MIPSU_RESULT_BAD_BREAK]      = "bad breakpoint address",
+    [MIPSU_RESULT_TOO_MANY_WATCH] = "too many watchpoints",
+    [MIPSU_RESULT_EMU_DONE]       = "program is not running",
+
+    [MIPSU_RESULT_BAD_ELF]  = "not an ELF32 MIPS file",
+    [MIPSU_RESULT_ELF_TEXT] = "no ELF text segment at or past 0x00400000",
+
+    [MIPSU_RESULT_BAD_LABEL]     = "undefined label",
+    [MIPSU_RESULT_DUP_LABEL]     = "label defined twice",
+    [MIPSU_RESULT_BAD_DIRECTIVE] = "unknown directive",
+
+    [MIPSU_RESULT_BAD_ENCODING] = "non-canonical encoding",
+    [MIPSU_RESULT_BAD_SWEEP]    = "legal encoding table is out of date",
+
+    [MIPSU_RESULT_BAD_FORMAT] = "unknown output format",
+
+    [MIPSU_RESULT_BAD_CACHE] = "cannot use cache directory",
+
+    [MIPSU_RESULT_BAD_BATCH]  = "bad batch line",
+    [MIPSU_RESULT_RUN_OUTPUT] = "output differs",
+    [MIPSU_RESULT_RUN_FAILED] = "some runs failed",
+
+    [MIPSU_RESULT_BAD_SNAP] = "bad snapshot file",
+    [MIPSU_RESULT_NO_SNAP]  = "no snapshot to restore",
+
+    [MIPSU_RESULT_BAD_HASH] = "hash table is out of date, reseed it",
 };
 
+#ifndef MIPSU_LIB
 static const mipsu_exit_t mipsu_err_lut[] = {
     [MIPSU_RESULT_OK] = MIPSU_EXIT_OK,
 
@@ -347,6 +1037,7 @@ static const mipsu_exit_t mipsu_err_lut[] = {
     [MIPSU_RESULT_RAW_STDIN]     = MIPSU_EXIT_USAGE,
     [MIPSU_RESULT_RAW_STDOUT]    = MIPSU_EXIT_USAGE,
     [MIPSU_RESULT_STDIN_CHAR]    = MIPSU_EXIT_USAGE,
+    [MIPSU_RESULT_BAD_JOBS]      = MIPSU_EXIT_USAGE,
 
     [MIPSU_RESULT_BAD_DEC]         = MIPSU_EXIT_PARSE,
     [MIPSU_RESULT_BAD_RADIX]       = MIPSU_EXIT_PARSE,
@@ -369,6 +1060,44 @@ static const mipsu_exit_t mipsu_err_lut[] = {
     [MIPSU_RESULT_BUFF_OVERFLOW] = MIPSU_EXIT_INTERNAL,
     [MIPSU_RESULT_READ_FILE]     = MIPSU_EXIT_INTERNAL,
     [MIPSU_RESULT_OPEN_FILE]     = MIPSU_EXIT_INTERNAL,
+    [MIPSU_RESULT_MAP_FILE]      = MIPSU_EXIT_INTERNAL,
+
+    [MIPSU_RESULT_EMU_INSTR]    = MIPSU_EXIT_EMU,
+    [MIPSU_RESULT_EMU_ADDR]     = MIPSU_EXIT_EMU,
+    [MIPSU_RESULT_EMU_PC]       = MIPSU_EXIT_EMU,
+    [MIPSU_RESULT_EMU_OVERFLOW] = MIPSU_EXIT_EMU,
+    [MIPSU_RESULT_EMU_SYSCALL]  = MIPSU_EXIT_EMU,
+    [MIPSU_RESULT_EMU_BREAK]    = MIPSU_EXIT_EMU,
+
+    [MIPSU_RESULT_BAD_PROF] = MIPSU_EXIT_PARSE,
+
+    [MIPSU_RESULT_BAD_DEBUG]      = MIPSU_EXIT_USAGE,
+    [MIPSU_RESULT_BAD_BREAK]      = MIPSU_EXIT_USAGE,
+    [MIPSU_RESULT_TOO_MANY_WATCH] = MIPSU_EXIT_USAGE,
+    [MIPSU_RESULT_EMU_DONE]       = MIPSU_EXIT_USAGE,
+
+    [MIPSU_RESULT_BAD_ELF]  = MIPSU_EXIT_PARSE,
+    [MIPSU_RESULT_ELF_TEXT] = MIPSU_EXIT_PARSE,
+
+    [MIPSU_RESULT_BAD_LABEL]     = MIPSU_EXIT_PARSE,
+    [MIPSU_RESULT_DUP_LABEL]     = MIPSU_EXIT_PARSE,
+    [MIPSU_RESULT_BAD_DIRECTIVE] = MIPSU_EXIT_PARSE,
+
+    [MIPSU_RESULT_BAD_ENCODING] = MIPSU_EXIT_PARSE,
+    [MIPSU_RESULT_BAD_SWEEP]    = MIPSU_EXIT_INTERNAL,
+
+    [MIPSU_RESULT_BAD_FORMAT] = MIPSU_EXIT_USAGE,
+
+    [MIPSU_RESULT_BAD_CACHE] = MIPSU_EXIT_INTERNAL,
+
+    [MIPSU_RESULT_BAD_BATCH]  = MIPSU_EXIT_PARSE,
+    [MIPSU_RESULT_RUN_OUTPUT] = MIPSU_EXIT_EMU,
+    [MIPSU_RESULT_RUN_FAILED] = MIPSU_EXIT_EMU,
+
+    [MIPSU_RESULT_BAD_SNAP] = MIPSU_EXIT_PARSE,
+    [MIPSU_RESULT_NO_SNAP]  = MIPSU_EXIT_USAGE,
+
+    [MIPSU_RESULT_BAD_HASH] = MIPSU_EXIT_INTERNAL,
 };
 
 static const mipsu_flag_entry_t mipsu_flag_lut[] = {
@@ -379,11 +1108,30 @@ static const mipsu_flag_entry_t mipsu_flag_lut[] = {
     {"dimm", MIPSU_FLAG_DIMM, 'd'},
     {"strict", MIPSU_FLAG_STRICT, 's'},
     {"raw", MIPSU_FLAG_RAW, 0},
+    {"elf", MIPSU_FLAG_ELF, 0},
+    {"be", MIPSU_FLAG_BE, 0},
+    {"le", MIPSU_FLAG_LE, 0},
+    {"hexdump", MIPSU_FLAG_HEXDUMP, 0},
+    {"diff", MIPSU_FLAG_DIFF, 0},
+    {"labels", MIPSU_FLAG_LABELS, 0},
+    {"resume", MIPSU_FLAG_RESUME, 0},
+    {"annotate", MIPSU_FLAG_ANNOTATE, 0},
+    {"host-fs", MIPSU_FLAG_HOST_FS, 0},
 };
 
 static const size_t mipsu_flagc =
     sizeof(mipsu_flag_lut) / sizeof(mipsu_flag_entry_t);
 
+/* --format names, each setting at most one flag */
+static const mipsu_flag_entry_t mipsu_format_lut[] = {
+    {"text", 0, 0},
+    {"jsonl", MIPSU_FLAG_JSONL, 0},
+    {"bin", MIPSU_FLAG_BIN, 0},
+};
+
+static const size_t mipsu_formatc =
+    sizeof(mipsu_format_lut) / sizeof(mipsu_flag_entry_t);
+
 static const char* mipsu_usage =
 
     "MIPS32 utilities\n"
@@ -392,11 +1140,21 @@ static const char* mipsu_usage =
     "  mipsu decode <hex | bin>\n"
     "  mipsu disasm <hex | bin>\n"
     "  mipsu disasm -f <file>\n"
+    "  mipsu disasm --diff <old> <new>\n"
     "  mipsu encode -R <rs> <rt> <rd> <sh> <fn>\n"
     "  mipsu encode -I <op> <rs> <rt> <imm>\n"
     "  mipsu encode -J <op> <addr>\n"
     "  mipsu asm    <mips>\n"
     "  mipsu asm    -f <file>\n"
+    "  mipsu stats  -f <file>\n"
+    "  mipsu cfg    -f <file>\n"
+    "  mipsu timing -f <file>\n"
+    "  mipsu run    -f <file>\n"
+    "  mipsu debug  -f <file>\n"
+    "  mipsu serve\n"
+    "  mipsu bench  [<words>]\n"
+    "  mipsu corpus [<words>]\n"
+    "  mipsu sweep  [<op>]\n"
     "  mipsu --version\n"
     "  mipsu --help | -h\n"
     "\n"
@@ -405,6 +1163,15 @@ static const char* mipsu_usage =
     "  disasm  32bit instruction -> assembly\n"
     "  encode  bitfield -> 32bit instruction\n"
     "  asm     assembly -> 32bit instruction\n"
+    "  stats   32bit instructions -> class, mnemonic and register counts\n"
+    "  cfg     32bit instructions -> basic blocks and their edges, as DOT\n"
+    "  timing  32bit instructions -> pipeline stalls and cycles per block\n"
+    "  run     emulate 32bit instructions loaded at 0x00400000\n"
+    "  debug   run with breakpoints and watchpoints, read from stdin\n"
+    "  serve   answer one command per input line until EOF\n"
+    "  bench   time decode, disasm, fmt_field, asm and encode on a corpus\n"
+    "  corpus  write the bench corpus, every instruction in turn\n"
+    "  sweep   check every encoding, printing the legal encoding table\n"
     "\n"
     "flags:\n"
     "  -q, --quiet     minimal output\n"
@@ -414,10 +1181,29 @@ static const char* mipsu_usage =
     "  -d, --dimm      use base 10 when formatting immediates\n"
     "  -s, --strict    enable strict parsing\n"
     "      --raw       handle raw binary files\n"
+    "      --elf       handle ELF32 files, by their sections and symbols\n"
+    "      --be        raw words are big-endian\n"
+    "      --le        raw words are little-endian\n"
+    "      --hexdump   read hex dumps, many words to a line, in disasm\n"
+    "      --diff      disasm only the words two raw files differ in\n"
+    "      --labels    label branch targets and split blocks in disasm\n"
+    "      --resume    run and debug snapshot files, saved by debug's k\n"
+    "      --annotate  list each word with its cycles in timing\n"
+    "      --host-fs   let run and debug guests open host files\n"
     "\n"
     "options:\n"
     "  -o <file>, --output <file>  Specify an output file\n"
-    "  -f <file>, --file   <file>  Specify an input file\n";
+    "  -f <file>, --file   <file>  Specify an input file\n"
+    "  -j <n>,    --jobs   <n>     Process raw input or --batch runs on <n>\n"
+    "             --profile <file> Write run counts to <file>, or annotate\n"
+    "                              disasm with them\n"
+    "             --format <fmt>   Write decode and disasm as text, jsonl or\n"
+    "                              bin records\n"
+    "             --cache <dir>    Keep raw disasm listings in <dir> by page,\n"
+    "                              redoing only pages not seen before\n"
+    "             --batch <file>   Run every <text> <stdin> <stdout> line of\n"
+    "                              <file> on -j threads, and check them\n";
+#endif
 
 static const size_t mipsu_word_size = sizeof(mipsu_word_t);
 
@@ -432,43 +1218,185 @@ static const uint8_t  mipsu_5bit_mask  = 0b00011111;
 static const uint16_t mipsu_16bit_mask = 0xFFFF;
 static const uint32_t mipsu_26bit_mask = 0x03FFFFFF;
 
-static const char* mipsu_fmt_none     = "%-8s\n";
-static const char* mipsu_fmt_hex8     = "%-8s 0x%08X\n";
-static const char* mipsu_fmt_1r       = "%-8s $%-4s\n";
-static const char* mipsu_fmt_2r       = "%-8s $%-4s, $%-4s\n";
-static const char* mipsu_fmt_3r       = "%-8s $%-4s, $%-4s, $%-4s\n";
-static const char* mipsu_fmt_2r_hex2  = "%-8s $%-4s, $%-4s, 0x%02hhX\n";
-static const char* mipsu_fmt_1r_dec6  = "%-8s $%-4s, %6hi\n";
-static const char* mipsu_fmt_2r_dec6  = "%-8s $%-4s, $%-4s, %6hi\n";
-static const char* mipsu_fmt_1r_hex4  = "%-8s $%-4s, 0x%04hX\n";
-static const char* mipsu_fmt_2r_hex4  = "%-8s $%-4s, $%-4s, 0x%04hX\n";
-static const char* mipsu_fmt_r_hex4_r = "%-8s $%-4s, 0x%04hX( $%s )\n";
+static const char mipsu_hexit_lut[] = "0123456789ABCDEF";
+
+static const size_t mipsu_mnem_width = 8;
+static const size_t mipsu_reg_width  = 4;
+static const size_t mipsu_dec_width  = 6;
+
+/* jal's link, and jalr's when it names none */
+static const uint8_t mipsu_reg_ra = 31;
+
+#ifndef MIPSU_LIB
+static const size_t mipsu_line_max = MIPSU_LINE_MAX;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+static const bool_t mipsu_host_be = true;
+#else
+static const bool_t mipsu_host_be = false;
+#endif
+
+/* multiple of the page size, so windows can be mapped at aligned offsets */
+static const size_t mipsu_map_window = 1 << 24;
+
+/* multiple of the cache page, so pipes are cached in the same pages */
+static const size_t mipsu_stream_block = 1 << 20;
+
+/* ELF32 header, section and segment values we read */
+static const uint8_t  mipsu_elf_magic[4]     = {0x7F, 'E', 'L', 'F'};
+static const uint8_t  mipsu_elf_class32      = 1;
+static const uint8_t  mipsu_elf_lsb          = 1;
+static const uint8_t  mipsu_elf_msb          = 2;
+static const uint16_t mipsu_elf_mips         = 8;
+static const uint32_t mipsu_elf_sht_progbits = 1;
+static const uint32_t mipsu_elf_sht_symtab   = 2;
+static const uint32_t mipsu_elf_shf_exec     = 1 << 2;
+static const uint32_t mipsu_elf_pt_load      = 1;
+static const uint32_t mipsu_elf_pf_x         = 1 << 0;
 
 static const char mipsu_color_err = '1';
 static const char mipsu_color_wrn = '3';
 
-static char mipsu_chr_buff[1024];
-static char mipsu_cp_buff[1024];
+/* words handed to a job per round, and the most jobs we will start */
+static const size_t mipsu_job_words = 1 << 15;
+static const size_t mipsu_job_max   = 256;
 
-static const size_t mipsu_chr_len = sizeof(mipsu_chr_buff);
-static const size_t mipsu_cp_len  = sizeof(mipsu_cp_buff);
-static const size_t mipsu_cp_last = mipsu_cp_len - 1;
+/* the SPIM memory layout, text first */
+static const uint32_t mipsu_text_base  = 0x00400000;
+static const uint32_t mipsu_data_base  = 0x10000000;
+static const uint32_t mipsu_heap_base  = 0x10040000;
+static const uint32_t mipsu_gp_init    = 0x10008000;
+static const uint32_t mipsu_sp_init    = 0x7FFFEFFC;
 
-/* === CLI utils === */
+/* sbrk stops short of the stack */
+static const uint32_t mipsu_heap_max = 0x70000000;
+static const uint32_t mipsu_files    = 16;
+
+/* sections of an assembly file, data laid out after text */
+static const uint8_t  mipsu_sect_text  = 0;
+static const uint8_t  mipsu_sect_data  = 1;
+static const uint8_t  mipsu_sects      = 2;
+static const uint32_t mipsu_label_seed = 0x9E3779B1;
+static const uint8_t  mipsu_align_max  = 16;
+
+/* a zero every immediate parser takes, standing in for a label */
+static const char* const mipsu_label_hole = "+0";
+
+/* longest block, bounding how far back a text store has to look */
+static const uint32_t mipsu_block_max = 64;
+
+static const uint8_t mipsu_page_bits  = 12;
+static const uint8_t mipsu_tlb_mask   = (1 << 4) - 1;
+static const uint8_t mipsu_table_bits = 10;
+static const size_t  mipsu_page_size  = 1 << 12;
+static const size_t  mipsu_arena_size = 1 << 20;
+
+static const uint8_t mipsu_reg_v0 = 2;
+static const uint8_t mipsu_reg_a0 = 4;
+static const uint8_t mipsu_reg_a1 = 5;
+static const uint8_t mipsu_reg_a2 = 6;
+static const uint8_t mipsu_reg_gp = 28;
+static const uint8_t mipsu_reg_sp = 29;
+
+static char mipsu_out_buff[1 << 18];
+
+static mipsu_buff_t mipsu_out = {mipsu_out_buff, 0, sizeof(mipsu_out_buff), 0};
+
+/* corpora are the same for a given size; paths keep their best of reps */
+static const uint32_t mipsu_bench_seed   = 0x9E3779B9;
+static const size_t   mipsu_bench_words  = 1 << 16;
+static const size_t   mipsu_bench_reps   = 9;
+static const size_t   mipsu_bench_stride = MIPSU_LINE_MAX;
+
+/* sweep threads take chunks of this many words in turn */
+static const uint64_t mipsu_sweep_chunk = 1 << 20;
+
+/* cached listings are per page of words; keys are FNV-1a, by word */
+static const size_t   mipsu_cache_page = 1 << 10;
+static const uint64_t mipsu_fnv_basis  = 0xCBF29CE484222325;
+static const uint64_t mipsu_fnv_prime  = 0x100000001B3;
+
+/* the flags that change a listing, and so its key */
+static const uint32_t mipsu_lib_flags = MIPSU_FLAG_QUIET | MIPSU_FLAG_NREG |
+                                        MIPSU_FLAG_DIMM | MIPSU_FLAG_STRICT;
+
+static const uint32_t mipsu_cache_flags = MIPSU_FLAG_QUIET | MIPSU_FLAG_NREG |
+                                          MIPSU_FLAG_DIMM | MIPSU_FLAG_STRICT |
+                                          MIPSU_FLAG_JSONL | MIPSU_FLAG_BIN;
 
-static bool_t mipsu_get_flag(mipsu_ctx_t c, mipsu_flag_t f) {
+/* what the paths compute, kept live so none of them is optimized away */
+static volatile size_t mipsu_bench_sink;
+
+/* tokens of an instruction; lines start with room for this many, and grow */
+static const size_t mipsu_lex_max = 64;
+
+/* serve requests: input read per syscall, output and tokens per request */
+static const size_t mipsu_req_argc = 16;
+
+static char mipsu_req_in[1 << 16];
+static char mipsu_req_out[1 << 16];
+#endif
+
+static bool_t mipsu_lib_flag(mipsu_ctx_t c, mipsu_flag_t f) {
     return c.flags & f;
 }
-static void mipsu_set_flag(mipsu_ctx_t* c, mipsu_flag_t f) { c->flags |= f; }
+
+#ifndef MIPSU_LIB
+static bool_t mipsu_get_flag(mipsu_cli_t c, uint32_t f) { return c.flags & f; }
+
+static void mipsu_set_flag(mipsu_cli_t* c, uint32_t f) { c->flags |= f; }
+
+/* the library's part of c, for its calls */
+static mipsu_ctx_t mipsu_lib(mipsu_cli_t c) {
+    mipsu_ctx_t l;
+
+    l.flags = (mipsu_flag_t)(c.flags & mipsu_lib_flags);
+
+    return l;
+}
+
+/* === CLI utils === */
+
+/* room for one more of the *n elements of size z at *p, doubling *cap */
+static bool_t mipsu_grow(void** p, size_t n, size_t* cap, size_t z) {
+    void* v;
+
+    if (n < *cap) return true;
+
+    v = realloc(*p, (*cap ? 2 * *cap : 1024) * z);
+    if (!v) return false;
+
+    *p   = v;
+    *cap = *cap ? 2 * *cap : 1024;
+
+    return true;
+}
+
+/* whether raw words are stored in the order the host does not use */
+static bool_t mipsu_swapped(mipsu_cli_t c) {
+    return mipsu_get_flag(c, mipsu_host_be ? MIPSU_FLAG_LE : MIPSU_FLAG_BE);
+}
+
+/* raw words and records would garble a terminal; serve replies have none */
+static bool_t mipsu_tty(file_t* f) { return f && isatty(fileno(f)); }
+
+static void mipsu_flush(mipsu_cli_t c) {
+    if (!c.o || !c.b || !c.b->n) return;
+
+    fwrite(c.b->data, 1, c.b->n, c.o);
+    c.b->n = 0;
+}
 
 static void mipsu_cerr(const char* msg, char col, const char* v,
-                       mipsu_ctx_t c) {
+                       mipsu_cli_t c) {
     char       start[6];
     const char reset[] = "\033[0m";
 
     bool_t no_col = mipsu_get_flag(c, MIPSU_FLAG_NO_COLOR);
     sprintf(start, "\033[3%cm", col);
 
+    mipsu_flush(c);
+
     if (v)
         fprintf(stderr,
                 "%smipsu%s: %s. '%s'\n",
@@ -484,52 +1412,47 @@ static void mipsu_cerr(const char* msg, char col, const char* v,
                 msg);
 }
 
-static void mipsu_err(const char* msg, mipsu_ctx_t c) {
+static void mipsu_err(const char* msg, mipsu_cli_t c) {
     mipsu_cerr(msg, mipsu_color_err, NULL, c);
 }
 
-static void mipsu_errv(const char* msg, const char* v, mipsu_ctx_t c) {
+static void mipsu_errv(const char* msg, const char* v, mipsu_cli_t c) {
     mipsu_cerr(msg, mipsu_color_err, v, c);
 }
 
-static void mipsu_wrnr(mipsu_result_t r, mipsu_ctx_t c) {
+static void mipsu_wrnr(mipsu_result_t r, mipsu_cli_t c) {
     mipsu_cerr(mipsu_res_msg_lut[r], mipsu_color_wrn, NULL, c);
 }
 
-static void mipsu_wrnrv(mipsu_result_t r, const char* v, mipsu_ctx_t c) {
+static void mipsu_wrnrv(mipsu_result_t r, const char* v, mipsu_cli_t c) {
     mipsu_cerr(mipsu_res_msg_lut[r], mipsu_color_wrn, v, c);
 }
 
 static void mipsu_exit_ok() { exit(MIPSU_EXIT_OK); }
 
-static void mipsu_exit(mipsu_exit_t e, mipsu_ctx_t c) {
+static void mipsu_exit(mipsu_exit_t e, mipsu_cli_t c) {
+    mipsu_flush(c);
     if (e) mipsu_err(mipsu_err_msg_lut[e], c);
     exit(e);
 }
 
-static void mipsu_exitr(mipsu_result_t r, mipsu_ctx_t c) {
+static void mipsu_exitr(mipsu_result_t r, mipsu_cli_t c) {
     if (r) mipsu_err(mipsu_res_msg_lut[r], c);
     mipsu_exit(mipsu_err_lut[r], c);
 }
 
-static void mipsu_exitrv(mipsu_result_t r, const char* v, mipsu_ctx_t c) {
+static void mipsu_exitrv(mipsu_result_t r, const char* v, mipsu_cli_t c) {
     if (r) mipsu_errv(mipsu_res_msg_lut[r], v, c);
     mipsu_exit(mipsu_err_lut[r], c);
 }
+#endif
 
 /* === Parsing === */
 
 static bool_t mipsu_ignore(char c) {
-    switch (c) {
-    case ' ':
-    case '\n':
-    case ',':
-    case '(':
-    case ')':
-        return true;
-    default:
-        return false;
-    }
+    uint8_t k = mipsu_chr_lut[(uint8_t)c];
+
+    return k == MIPSU_CHR_SEP || k == MIPSU_CHR_EOL;
 }
 
 static bool_t mipsu_bin_spec(char c) { return c == 'B' || c == 'b'; }
@@ -617,7 +1540,7 @@ static mipsu_result_t mipsu_parse_value(const char* s, mipsu_word_t* out,
     return MIPSU_RESULT_OK;
 }
 
-static mipsu_result_t mipsu_parse_word(const char* s, mipsu_word_t* out) {
+mipsu_result_t mipsu_parse_word(const char* s, mipsu_word_t* out) {
     return mipsu_parse_value(s, out, true, mipsu_word_size * 8);
 }
 
@@ -653,8 +1576,9 @@ static mipsu_result_t mipsu_parse_addr(const char* s, uint32_t* addr) {
     return r;
 }
 
+#ifndef MIPSU_LIB
 static mipsu_result_t mipsu_parse_type(const char* s, mipsu_type_t* out,
-                                       mipsu_ctx_t c) {
+                                       mipsu_cli_t c) {
     if (strlen(s) > 2) return MIPSU_RESULT_BAD_OP_TYPE;
 
     bool_t prefixed = s[0] == '-';
@@ -686,7 +1610,7 @@ static mipsu_result_t mipsu_parse_type(const char* s, mipsu_type_t* out,
 
 static mipsu_result_t mipsu_parse_field_hlpr(const char* s, const char* msg,
                                              uint8_t* f, uint8_t n,
-                                             mipsu_ctx_t c) {
+                                             mipsu_cli_t c) {
     mipsu_result_t r;
     mipsu_word_t   w;
 
@@ -699,7 +1623,7 @@ static mipsu_result_t mipsu_parse_field_hlpr(const char* s, const char* msg,
 }
 
 static mipsu_result_t mipsu_parse_r_field(int32_t argc, const char** argv,
-                                          mipsu_field_t* out, mipsu_ctx_t c) {
+                                          mipsu_field_t* out, mipsu_cli_t c) {
     mipsu_result_t r;
 
     if (argc < 6) return MIPSU_RESULT_MISSING_ARGS;
@@ -726,7 +1650,7 @@ static mipsu_result_t mipsu_parse_r_field(int32_t argc, const char** argv,
 }
 
 static mipsu_result_t mipsu_parse_i_field(int32_t argc, const char** argv,
-                                          mipsu_field_t* out, mipsu_ctx_t c) {
+                                          mipsu_field_t* out, mipsu_cli_t c) {
     mipsu_result_t r;
 
     if (argc < 5) return MIPSU_RESULT_MISSING_ARGS;
@@ -750,7 +1674,7 @@ static mipsu_result_t mipsu_parse_i_field(int32_t argc, const char** argv,
 }
 
 static mipsu_result_t mipsu_parse_j_field(int32_t argc, const char** argv,
-                                          mipsu_field_t* out, mipsu_ctx_t c) {
+                                          mipsu_field_t* out, mipsu_cli_t c) {
     mipsu_result_t r;
     mipsu_word_t   w;
 
@@ -770,7 +1694,7 @@ static mipsu_result_t mipsu_parse_j_field(int32_t argc, const char** argv,
 }
 
 static mipsu_result_t mipsu_parse_field(int32_t argc, const char** argv,
-                                        mipsu_field_t* out, mipsu_ctx_t c) {
+                                        mipsu_field_t* out, mipsu_cli_t c) {
     mipsu_type_t   t;
     mipsu_result_t r;
 
@@ -789,42 +1713,71 @@ static mipsu_result_t mipsu_parse_field(int32_t argc, const char** argv,
         return mipsu_parse_j_field(argc, argv, out, c);
     }
 }
+#endif
+
+static size_t mipsu_hash(const char* s, size_t n, uint32_t seed,
+                         uint8_t bits) {
+    uint32_t h = 0x811C9DC5;
+    size_t   i;
+
+    for (i = 0; i < n; ++i)
+        h = (h ^ (uint8_t)s[i]) * 0x01000193;
+
+    return (uint32_t)(h * seed) >> (32 - bits);
+}
 
 static mipsu_result_t mipsu_parse_op(const char* s, mipsu_op_entry_t* e,
                                      uint8_t* o) {
-    size_t i;
+    size_t                  n = strlen(s);
+    const mipsu_op_entry_t* h;
 
-    for (i = 0; i < mipsu_fnc; ++i) {
-        *o = mipsu_fnv[i];
-        *e = mipsu_fn_lut[*o];
-        if (!strcmp(s, e->mnem)) return MIPSU_RESULT_OK;
-    }
+    h = mipsu_mnem_hash_lut[mipsu_hash(s, n, mipsu_mnem_seed, mipsu_mnem_bits)];
+
+    if (!h || h->len != n || memcmp(h->mnem, s, n)) return MIPSU_RESULT_BAD_OP;
+
+    *e = *h;
+    *o = (h - mipsu_instr_lut) & mipsu_6bit_mask;
 
-    for (i = 0; i < mipsu_opc; ++i) {
-        *o = mipsu_opv[i];
-        *e = mipsu_op_lut[*o];
-        if (!strcmp(s, e->mnem)) return MIPSU_RESULT_OK;
+    return MIPSU_RESULT_OK;
+}
+
+static bool_t mipsu_dec_digit(char c) { return c >= '0' && c <= '9'; }
+
+static bool_t mipsu_parse_reg_num(const char* s, uint8_t* r) {
+    if (!mipsu_dec_digit(s[0])) return false;
+
+    if (!s[1]) {
+        *r = s[0] - '0';
+        return true;
     }
 
-    return MIPSU_RESULT_BAD_OP;
+    if (s[0] == '0' || !mipsu_dec_digit(s[1]) || s[2]) return false;
+
+    *r = (s[0] - '0') * 10 + (s[1] - '0');
+
+    return *r < mipsu_regc;
 }
 
 static mipsu_result_t mipsu_parse_reg(const char* s, uint8_t* r,
                                       mipsu_ctx_t c) {
+    const mipsu_reg_entry_t* h;
 
     bool_t prefixed = s[0] == '$';
-    bool_t strict   = mipsu_get_flag(c, MIPSU_FLAG_STRICT);
+    bool_t strict   = mipsu_lib_flag(c, MIPSU_FLAG_STRICT);
 
     if (!prefixed && strict) return MIPSU_RESULT_BAD_REG;
 
     if (prefixed) ++s;
 
-    for (*r = 0; *r < mipsu_regc; ++(*r))
-        if (!strcmp(s, mipsu_reg_lut[*r].name)) return MIPSU_RESULT_OK;
-    for (*r = 0; *r < mipsu_regc; ++(*r))
-        if (!strcmp(s, mipsu_reg_lut[*r].num)) return MIPSU_RESULT_OK;
+    h = mipsu_reg_hash_lut[mipsu_hash(
+        s, strlen(s), mipsu_reg_seed, mipsu_reg_bits)];
+
+    if (h && !strcmp(s, h->name)) {
+        *r = h - mipsu_reg_lut;
+        return MIPSU_RESULT_OK;
+    }
 
-    return MIPSU_RESULT_BAD_REG;
+    return mipsu_parse_reg_num(s, r) ? MIPSU_RESULT_OK : MIPSU_RESULT_BAD_REG;
 }
 
 static mipsu_result_t mipsu_parse_1r(size_t n, const char** a, uint8_t* r1,
@@ -930,89 +1883,219 @@ static mipsu_result_t mipsu_parse_r_imm_r(size_t n, const char** a, uint8_t* r1,
     return r;
 }
 
-static mipsu_result_t mipsu_parse_asm(const char* s, const char** a,
-                                      size_t* n) {
+/* splits b in place into at most m tokens, false if there are more */
+static bool_t mipsu_split(char* b, const char** a, size_t m, size_t* n) {
     size_t i;
 
     *n = 0;
 
-    strncpy(mipsu_cp_buff, s, mipsu_cp_last);
+    for (i = 0; b[i]; ++i) {
 
-    if (mipsu_cp_buff[mipsu_cp_last]) return MIPSU_RESULT_BUFF_OVERFLOW;
+        if (mipsu_ignore(b[i])) continue;
 
-    for (i = 0; mipsu_cp_buff[i]; ++i) {
-
-        if (mipsu_ignore(mipsu_cp_buff[i])) continue;
-
-        if (*n < 4)
-            a[(*n)++] = mipsu_cp_buff + i;
+        if (*n < m)
+            a[(*n)++] = b + i;
 
         else
-            return MIPSU_RESULT_INSTR_SIZE;
+            return false;
 
-        while (!mipsu_ignore(mipsu_cp_buff[i]) && mipsu_cp_buff[i])
+        while (!mipsu_ignore(b[i]) && b[i])
             ++i;
 
-        mipsu_cp_buff[i] = 0;
+        if (!b[i]) break;
+
+        b[i] = 0;
     }
 
-    return MIPSU_RESULT_OK;
+    return true;
 }
 
-/* === Formatting === */
+static mipsu_result_t mipsu_parse_asm(const char* s, char* b, size_t l,
+                                      const char** a, size_t* n) {
+    size_t i = strlen(s);
 
-static size_t mipsu_fmt_field(mipsu_word_t w, mipsu_field_t f, char* b,
-                              mipsu_ctx_t c) {
+    *n = 0;
 
-    const mipsu_reg_entry_t rse = mipsu_reg_lut[f.rs];
-    const mipsu_reg_entry_t rte = mipsu_reg_lut[f.rt];
-    const mipsu_reg_entry_t rde = mipsu_reg_lut[f.rd];
+    if (i >= l) return MIPSU_RESULT_BUFF_OVERFLOW;
 
-    bool_t nreg = mipsu_get_flag(c, MIPSU_FLAG_NREG);
+    memcpy(b, s, i + 1);
 
-    const char* rs = nreg ? rse.num : rse.name;
-    const char* rt = nreg ? rte.num : rte.name;
-    const char* rd = nreg ? rde.num : rde.name;
+    return mipsu_split(b, a, 4, n) ? MIPSU_RESULT_OK
+                                   : MIPSU_RESULT_INSTR_SIZE;
+}
 
-    const char* fn = mipsu_fn_lut[f.fn].mnem;
-    const char* op = mipsu_op_lut[f.op].mnem;
+/* === Formatting === */
 
-    size_t o = 0;
+static char* mipsu_put_chr(char* p, char c, size_t n) {
+    for (; n; --n)
+        *p++ = c;
 
-    char t;
+    return p;
+}
 
-    if (!op || (f.type == MIPSU_TYPE_R && !fn))
-        mipsu_wrnr(MIPSU_RESULT_BAD_INSTR, c);
+static char* mipsu_put_str(char* p, const char* s) {
+    while (*s)
+        *p++ = *s++;
 
-    if (!mipsu_get_flag(c, MIPSU_FLAG_QUIET)) {
-        t = mipsu_type_lut[f.type];
+    return p;
+}
+
+static char* mipsu_put_pad(char* p, const char* s, size_t w) {
+    char* e = mipsu_put_str(p, s);
+
+    return (size_t)(e - p) < w ? mipsu_put_chr(e, ' ', w - (e - p)) : e;
+}
+
+static char* mipsu_put_hex(char* p, mipsu_word_t v, size_t n) {
+    size_t i;
+
+    *p++ = '0';
+    *p++ = 'x';
+
+    for (i = n; i; --i, v >>= 4)
+        p[i - 1] = mipsu_hexit_lut[v & 0xF];
+
+    return p + n;
+}
+
+static char* mipsu_put_dec(char* p, int32_t v, size_t w) {
+    char     t[12];
+    size_t   n = 0;
+    uint32_t u = v < 0 ? -(uint32_t)v : (uint32_t)v;
+
+    do {
+        t[n++] = '0' + u % 10;
+        u /= 10;
+    } while (u);
+
+    if (v < 0) t[n++] = '-';
+
+    if (w > n) p = mipsu_put_chr(p, ' ', w - n);
+
+    while (n)
+        *p++ = t[--n];
+
+    return p;
+}
+
+#ifndef MIPSU_LIB
+static char* mipsu_put_cnt(char* p, uint64_t v, size_t w) {
+    char   t[20];
+    size_t n = 0;
+
+    do {
+        t[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+
+    if (w > n) p = mipsu_put_chr(p, ' ', w - n);
+
+    while (n)
+        *p++ = t[--n];
+
+    return p;
+}
+#endif
+
+static const char* mipsu_reg_str(uint8_t r, mipsu_ctx_t c) {
+    mipsu_reg_entry_t e = mipsu_reg_lut[r];
+
+    return mipsu_lib_flag(c, MIPSU_FLAG_NREG) ? e.num : e.name;
+}
+
+static char* mipsu_put_reg(char* p, uint8_t r, size_t w, mipsu_ctx_t c) {
+    *p++ = '$';
+
+    return mipsu_put_pad(p, mipsu_reg_str(r, c), w);
+}
+
+static char* mipsu_put_imm(char* p, int16_t imm, mipsu_ctx_t c) {
+    if (mipsu_lib_flag(c, MIPSU_FLAG_DIMM))
+        return mipsu_put_dec(p, imm, mipsu_dec_width);
+
+    return mipsu_put_hex(p, (uint16_t)imm, 4);
+}
 
-        o += sprintf(b + o, "hex:   0x%08X\n", w);
-        o += sprintf(b + o, "type:  %c%s\n", t, op ? "" : "?");
-        o += sprintf(b + o, "--------\n");
+static char* mipsu_put_key(char* p, const char* k, mipsu_word_t v, size_t n,
+                           size_t w) {
+    p    = mipsu_put_str(p, k);
+    p    = mipsu_put_hex(p, v, n);
+    p    = mipsu_put_chr(p, ' ', w);
+    *p++ = '(';
+
+    return p;
+}
+
+static char* mipsu_put_val(char* p, const char* v) {
+    p    = mipsu_put_str(p, v);
+    *p++ = ')';
+    *p++ = '\n';
+
+    return p;
+}
+
+static char* mipsu_put_dec_val(char* p, int32_t v) {
+    p    = mipsu_put_dec(p, v, 0);
+    *p++ = ')';
+    *p++ = '\n';
+
+    return p;
+}
+
+static char* mipsu_put_reg_val(char* p, const char* k, uint8_t r, size_t w,
+                               mipsu_ctx_t c) {
+    p    = mipsu_put_key(p, k, r, 2, w);
+    *p++ = '$';
+
+    return mipsu_put_val(p, mipsu_reg_str(r, c));
+}
+
+size_t mipsu_fmt_field(mipsu_word_t w, mipsu_field_t f, char* b,
+                       mipsu_ctx_t c) {
+
+    const char* fn = mipsu_fn_lut[f.fn].mnem;
+    const char* op = mipsu_op_lut[f.op].mnem;
+
+    char* p = b;
+
+    if (!mipsu_lib_flag(c, MIPSU_FLAG_QUIET)) {
+        p    = mipsu_put_str(p, "hex:   ");
+        p    = mipsu_put_hex(p, w, 8);
+        p    = mipsu_put_str(p, "\ntype:  ");
+        *p++ = mipsu_type_lut[f.type];
+        p    = mipsu_put_str(p, op ? "\n" : "?\n");
+        p    = mipsu_put_str(p, "--------\n");
     }
 
     switch (f.type) {
     case MIPSU_TYPE_R:
-        o += sprintf(b + o, "rs:  0x%02hhX  ($%s)\n", f.rs, rs);
-        o += sprintf(b + o, "rt:  0x%02hhX  ($%s)\n", f.rt, rt);
-        o += sprintf(b + o, "rd:  0x%02hhX  ($%s)\n", f.rd, rd);
-        o += sprintf(b + o, "sh:  0x%02hhX  (%hhu)\n", f.sh, f.sh);
-        o += sprintf(b + o, "fn:  0x%02hhX  (%s)\n", f.fn, fn ? fn : "?");
+        p = mipsu_put_reg_val(p, "rs:  ", f.rs, 2, c);
+        p = mipsu_put_reg_val(p, "rt:  ", f.rt, 2, c);
+        p = mipsu_put_reg_val(p, "rd:  ", f.rd, 2, c);
+        p = mipsu_put_key(p, "sh:  ", f.sh, 2, 2);
+        p = mipsu_put_dec_val(p, f.sh);
+        p = mipsu_put_key(p, "fn:  ", f.fn, 2, 2);
+        p = mipsu_put_val(p, fn ? fn : "?");
         break;
     case MIPSU_TYPE_I:
-        o += sprintf(b + o, "op:   0x%02hhX    (%s)\n", f.op, op ? op : "?");
-        o += sprintf(b + o, "rs:   0x%02hhX    ($%s)\n", f.rs, rs);
-        o += sprintf(b + o, "rt:   0x%02hhX    ($%s)\n", f.rt, rt);
-        o += sprintf(b + o, "imm:  0x%04hX  (%hi)\n", f.imm, f.imm);
+        p = mipsu_put_key(p, "op:   ", f.op, 2, 4);
+        p = mipsu_put_val(p, op ? op : "?");
+        p = mipsu_put_reg_val(p, "rs:   ", f.rs, 4, c);
+        p = mipsu_put_reg_val(p, "rt:   ", f.rt, 4, c);
+        p = mipsu_put_key(p, "imm:  ", (uint16_t)f.imm, 4, 2);
+        p = mipsu_put_dec_val(p, f.imm);
         break;
     case MIPSU_TYPE_J:
-        o += sprintf(b + o, "op:    0x%02hhX      (%s)\n", f.op, op ? op : "?");
-        o += sprintf(b + o, "addr:  0x%08X  (%u)\n", f.addr, f.addr);
+        p = mipsu_put_key(p, "op:    ", f.op, 2, 6);
+        p = mipsu_put_val(p, op ? op : "?");
+        p = mipsu_put_key(p, "addr:  ", f.addr, 8, 2);
+        p = mipsu_put_dec_val(p, f.addr);
         break;
     }
 
-    return o;
+    *p = 0;
+
+    return p - b;
 }
 
 /* === Decoding === */
@@ -1036,33 +2119,298 @@ static uint8_t  mipsu_fn(mipsu_word_t w) { return w & mipsu_6bit_mask; }
 static int16_t  mipsu_imm(mipsu_word_t w) { return w & mipsu_16bit_mask; }
 static uint32_t mipsu_addr(mipsu_word_t w) { return w & mipsu_26bit_mask; }
 
-static mipsu_field_t mipsu_decode(mipsu_word_t w) {
-    mipsu_field_t f;
-    f.op = mipsu_op(w);
-
-    if (f.op == 0) {
-        f.type = MIPSU_TYPE_R;
-        f.rs   = mipsu_rs(w);
-        f.rt   = mipsu_rt(w);
-        f.rd   = mipsu_rd(w);
-        f.sh   = mipsu_sh(w);
-        f.fn   = mipsu_fn(w);
-    } else if (f.op == 2 || f.op == 3) {
-        f.type = MIPSU_TYPE_J;
+static size_t mipsu_instr_idx(mipsu_word_t w) {
+    uint8_t op = mipsu_op(w);
+
+    return op ? MIPSU_OP(op) : MIPSU_FN(mipsu_fn(w));
+}
+
+static const mipsu_op_entry_t* mipsu_instr(mipsu_word_t w) {
+    return mipsu_instr_lut + mipsu_instr_idx(w);
+}
+
+mipsu_field_t mipsu_decode(mipsu_word_t w) {
+    mipsu_field_t f = {};
+
+    f.op   = mipsu_op(w);
+    f.type = mipsu_op_lut[f.op].type;
+
+    switch (f.type) {
+    case MIPSU_TYPE_R:
+        f.rs = mipsu_rs(w);
+        f.rt = mipsu_rt(w);
+        f.rd = mipsu_rd(w);
+        f.sh = mipsu_sh(w);
+        f.fn = mipsu_fn(w);
+        break;
+    case MIPSU_TYPE_I:
+        f.rs  = mipsu_rs(w);
+        f.rt  = mipsu_rt(w);
+        f.imm = mipsu_imm(w);
+        break;
+    case MIPSU_TYPE_J:
         f.addr = mipsu_addr(w);
-    } else {
-        f.type = MIPSU_TYPE_I;
-        f.rs   = mipsu_rs(w);
-        f.rt   = mipsu_rt(w);
-        f.imm  = mipsu_imm(w);
+        break;
     }
 
+    f.res = mipsu_verify(w);
+
     return f;
 }
 
+#if defined(__AVX2__)
+static const size_t mipsu_vec_words = 32;
+
+static __m256i mipsu_vec_shr(const mipsu_word_t* w, uint8_t sh, uint32_t m) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)w);
+
+    return _mm256_and_si256(_mm256_srl_epi32(v, _mm_cvtsi32_si128(sh)),
+                            _mm256_set1_epi32(m));
+}
+
+/* packs work per 128-bit lane, so the dwords are put back in order */
+static void mipsu_vec_u8(const mipsu_word_t* w, uint8_t sh, uint32_t m,
+                         uint8_t* o) {
+    __m256i a = _mm256_packs_epi32(mipsu_vec_shr(w, sh, m),
+                                   mipsu_vec_shr(w + 8, sh, m));
+    __m256i b = _mm256_packs_epi32(mipsu_vec_shr(w + 16, sh, m),
+                                   mipsu_vec_shr(w + 24, sh, m));
+    __m256i i = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    __m256i v = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(a, b), i);
+
+    _mm256_storeu_si256((__m256i*)o, v);
+}
+
+/* sign extended first, so the saturating pack is exact */
+static void mipsu_vec_imm(const mipsu_word_t* w, int16_t* o) {
+    __m256i a, b;
+    size_t  i;
+
+    for (i = 0; i < mipsu_vec_words; i += 16) {
+        a = _mm256_loadu_si256((const __m256i*)(w + i));
+        b = _mm256_loadu_si256((const __m256i*)(w + i + 8));
+        a = _mm256_srai_epi32(_mm256_slli_epi32(a, 16), 16);
+        b = _mm256_srai_epi32(_mm256_slli_epi32(b, 16), 16);
+        a = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+        _mm256_storeu_si256((__m256i*)(o + i), a);
+    }
+}
+
+static void mipsu_vec_addr(const mipsu_word_t* w, uint32_t* o) {
+    __m256i m = _mm256_set1_epi32(mipsu_26bit_mask);
+    size_t  i;
+
+    for (i = 0; i < mipsu_vec_words; i += 8)
+        _mm256_storeu_si256(
+            (__m256i*)(o + i),
+            _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(w + i)), m));
+}
+
+static void mipsu_vec_swap(mipsu_word_t* w) {
+    __m256i m = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14,
+                                 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8,
+                                 15, 14, 13, 12);
+    __m256i v;
+    size_t  i;
+
+    for (i = 0; i < mipsu_vec_words; i += 8) {
+        v = _mm256_loadu_si256((const __m256i*)(w + i));
+        _mm256_storeu_si256((__m256i*)(w + i), _mm256_shuffle_epi8(v, m));
+    }
+}
+#elif defined(__SSE2__)
+static const size_t mipsu_vec_words = 16;
+
+static __m128i mipsu_vec_shr(const mipsu_word_t* w, uint8_t sh, uint32_t m) {
+    __m128i v = _mm_loadu_si128((const __m128i*)w);
+
+    return _mm_and_si128(_mm_srl_epi32(v, _mm_cvtsi32_si128(sh)),
+                         _mm_set1_epi32(m));
+}
+
+static void mipsu_vec_u8(const mipsu_word_t* w, uint8_t sh, uint32_t m,
+                         uint8_t* o) {
+    __m128i a = _mm_packs_epi32(mipsu_vec_shr(w, sh, m),
+                                mipsu_vec_shr(w + 4, sh, m));
+    __m128i b = _mm_packs_epi32(mipsu_vec_shr(w + 8, sh, m),
+                                mipsu_vec_shr(w + 12, sh, m));
+
+    _mm_storeu_si128((__m128i*)o, _mm_packus_epi16(a, b));
+}
+
+/* sign extended first, so the saturating pack is exact */
+static void mipsu_vec_imm(const mipsu_word_t* w, int16_t* o) {
+    __m128i a, b;
+    size_t  i;
+
+    for (i = 0; i < mipsu_vec_words; i += 8) {
+        a = _mm_loadu_si128((const __m128i*)(w + i));
+        b = _mm_loadu_si128((const __m128i*)(w + i + 4));
+        a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+        b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+        _mm_storeu_si128((__m128i*)(o + i), _mm_packs_epi32(a, b));
+    }
+}
+
+static void mipsu_vec_addr(const mipsu_word_t* w, uint32_t* o) {
+    __m128i m = _mm_set1_epi32(mipsu_26bit_mask);
+    size_t  i;
+
+    for (i = 0; i < mipsu_vec_words; i += 4)
+        _mm_storeu_si128(
+            (__m128i*)(o + i),
+            _mm_and_si128(_mm_loadu_si128((const __m128i*)(w + i)), m));
+}
+
+/* no byte shuffle before SSSE3: swap bytes in halves, then the halves */
+static void mipsu_vec_swap(mipsu_word_t* w) {
+    __m128i v;
+    size_t  i;
+
+    for (i = 0; i < mipsu_vec_words; i += 4) {
+        v = _mm_loadu_si128((const __m128i*)(w + i));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+        _mm_storeu_si128((__m128i*)(w + i), v);
+    }
+}
+#elif defined(__ARM_NEON)
+static const size_t mipsu_vec_words = 16;
+
+static uint16x4_t mipsu_vec_shr(const mipsu_word_t* w, uint8_t sh,
+                                uint32_t m) {
+    uint32x4_t v = vshlq_u32(vld1q_u32(w), vdupq_n_s32(-(int32_t)sh));
+
+    return vmovn_u32(vandq_u32(v, vdupq_n_u32(m)));
+}
+
+static void mipsu_vec_u8(const mipsu_word_t* w, uint8_t sh, uint32_t m,
+                         uint8_t* o) {
+    uint16x8_t a = vcombine_u16(mipsu_vec_shr(w, sh, m),
+                                mipsu_vec_shr(w + 4, sh, m));
+    uint16x8_t b = vcombine_u16(mipsu_vec_shr(w + 8, sh, m),
+                                mipsu_vec_shr(w + 12, sh, m));
+
+    vst1q_u8(o, vcombine_u8(vmovn_u16(a), vmovn_u16(b)));
+}
+
+/* narrowing keeps the low half, which is the immediate as is */
+static void mipsu_vec_imm(const mipsu_word_t* w, int16_t* o) {
+    uint16x8_t v;
+    size_t     i;
+
+    for (i = 0; i < mipsu_vec_words; i += 8) {
+        v = vcombine_u16(vmovn_u32(vld1q_u32(w + i)),
+                         vmovn_u32(vld1q_u32(w + i + 4)));
+        vst1q_s16(o + i, vreinterpretq_s16_u16(v));
+    }
+}
+
+static void mipsu_vec_addr(const mipsu_word_t* w, uint32_t* o) {
+    uint32x4_t m = vdupq_n_u32(mipsu_26bit_mask);
+    size_t     i;
+
+    for (i = 0; i < mipsu_vec_words; i += 4)
+        vst1q_u32(o + i, vandq_u32(vld1q_u32(w + i), m));
+}
+
+static void mipsu_vec_swap(mipsu_word_t* w) {
+    size_t i;
+
+    for (i = 0; i < mipsu_vec_words; i += 4)
+        vst1q_u32(w + i, vreinterpretq_u32_u8(vrev32q_u8(
+                             vreinterpretq_u8_u32(vld1q_u32(w + i)))));
+}
+#endif
+
+void mipsu_decode_bulk(const mipsu_word_t* w, size_t n, mipsu_fields_t f) {
+    size_t i = 0;
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+    for (; i + mipsu_vec_words <= n; i += mipsu_vec_words) {
+        const mipsu_word_t* v = w + i;
+
+        if (f.op) mipsu_vec_u8(v, mipsu_op_offset, mipsu_6bit_mask, f.op + i);
+        if (f.rs) mipsu_vec_u8(v, mipsu_rs_offset, mipsu_5bit_mask, f.rs + i);
+        if (f.rt) mipsu_vec_u8(v, mipsu_rt_offset, mipsu_5bit_mask, f.rt + i);
+        if (f.rd) mipsu_vec_u8(v, mipsu_rd_offset, mipsu_5bit_mask, f.rd + i);
+        if (f.sh) mipsu_vec_u8(v, mipsu_sh_offset, mipsu_5bit_mask, f.sh + i);
+        if (f.fn) mipsu_vec_u8(v, 0, mipsu_6bit_mask, f.fn + i);
+        if (f.imm) mipsu_vec_imm(v, f.imm + i);
+        if (f.addr) mipsu_vec_addr(v, f.addr + i);
+    }
+#endif
+
+    for (; i < n; ++i) {
+        if (f.op) f.op[i] = mipsu_op(w[i]);
+        if (f.rs) f.rs[i] = mipsu_rs(w[i]);
+        if (f.rt) f.rt[i] = mipsu_rt(w[i]);
+        if (f.rd) f.rd[i] = mipsu_rd(w[i]);
+        if (f.sh) f.sh[i] = mipsu_sh(w[i]);
+        if (f.fn) f.fn[i] = mipsu_fn(w[i]);
+        if (f.imm) f.imm[i] = mipsu_imm(w[i]);
+        if (f.addr) f.addr[i] = mipsu_addr(w[i]);
+    }
+
+    /* a gather per word, which no vector unit here does cheaper */
+    if (f.bad)
+        for (i = 0; i < n; ++i)
+            f.bad[i] = !!(w[i] & ~mipsu_legal_lut[mipsu_instr_idx(w[i])]);
+}
+
+static mipsu_word_t mipsu_swap(mipsu_word_t w) {
+    return w >> 24 | (w >> 8 & 0xFF00) | (w << 8 & 0xFF0000) | w << 24;
+}
+
+/* one pass in place, turning words from one byte order to the other */
+void mipsu_swap_words(mipsu_word_t* w, size_t n) {
+    size_t i = 0;
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+    for (; i + mipsu_vec_words <= n; i += mipsu_vec_words)
+        mipsu_vec_swap(w + i);
+#endif
+
+    for (; i < n; ++i)
+        w[i] = mipsu_swap(w[i]);
+}
+
+/* fields are staged through the bulk decoder this many words at a time */
+static const size_t mipsu_stats_words = 1 << 10;
+
+/* branch free: each role bit is shifted down to a 0 or 1 increment */
+void mipsu_stats_add(const mipsu_word_t* w, size_t n, mipsu_stats_t* s) {
+    uint8_t        op[mipsu_stats_words], rs[mipsu_stats_words];
+    uint8_t        rt[mipsu_stats_words], rd[mipsu_stats_words];
+    uint8_t        fn[mipsu_stats_words];
+    mipsu_fields_t f = {op, rs, rt, rd, NULL, fn, NULL, NULL, NULL};
+    size_t         i, k, m, x;
+
+    const mipsu_op_entry_t* e;
+
+    for (i = 0; i < n; i += m) {
+        m = n - i < mipsu_stats_words ? n - i : mipsu_stats_words;
+
+        mipsu_decode_bulk(w + i, m, f);
+
+        for (k = 0; k < m; ++k) {
+            e = op[k] ? mipsu_op_lut + op[k] : mipsu_fn_lut + fn[k];
+            x = e - mipsu_instr_lut;
+
+            s->instr[x]++;
+            s->bad += !!(w[i + k] & ~mipsu_legal_lut[x]);
+            s->reads[rs[k]] += e->use & MIPSU_ROLE_RS;
+            s->reads[rt[k]] += (e->use & MIPSU_ROLE_RT) >> 1;
+            s->writes[rt[k]] += (e->def & MIPSU_ROLE_RT) >> 1;
+            s->writes[rd[k]] += (e->def & MIPSU_ROLE_RD) >> 2;
+            s->writes[31] += (e->def & MIPSU_ROLE_RA) >> 3;
+        }
+    }
+}
+
 /* === Encoding === */
 
-static mipsu_word_t mipsu_encode(mipsu_field_t f) {
+mipsu_word_t mipsu_encode(mipsu_field_t f) {
 
     switch (f.type) {
     case MIPSU_TYPE_R:
@@ -1083,73 +2431,78 @@ static mipsu_word_t mipsu_encode(mipsu_field_t f) {
 
 /* === Disassembly === */
 
-static size_t mipsu_disasm(mipsu_field_t f, char* b, mipsu_ctx_t c) {
-
-    const mipsu_reg_entry_t rse = mipsu_reg_lut[f.rs];
-    const mipsu_reg_entry_t rte = mipsu_reg_lut[f.rt];
-    const mipsu_reg_entry_t rde = mipsu_reg_lut[f.rd];
-
-    bool_t nreg = mipsu_get_flag(c, MIPSU_FLAG_NREG);
-    bool_t dimm = mipsu_get_flag(c, MIPSU_FLAG_DIMM);
-
-    const char* fmt_1r_imm = dimm ? mipsu_fmt_1r_dec6 : mipsu_fmt_1r_hex4;
-    const char* fmt_2r_imm = dimm ? mipsu_fmt_2r_dec6 : mipsu_fmt_2r_hex4;
-
-    const char* rs = nreg ? rse.num : rse.name;
-    const char* rt = nreg ? rte.num : rte.name;
-    const char* rd = nreg ? rde.num : rde.name;
-
-    mipsu_op_entry_t e;
-
-    if (f.type == MIPSU_TYPE_R)
-        e = mipsu_fn_lut[f.fn];
-    else
-        e = mipsu_op_lut[f.op];
-
-    switch (e.fmt) {
-    case MIPSU_OP_FMT_UNKNOWN:
-        return sprintf(b, mipsu_fmt_hex8, ".word", mipsu_encode(f));
-    case MIPSU_OP_FMT_NONE:
-        return sprintf(b, mipsu_fmt_none, e.mnem);
-
-    case MIPSU_OP_FMT_RS:
-        return sprintf(b, mipsu_fmt_1r, e.mnem, rs);
-    case MIPSU_OP_FMT_RD:
-        return sprintf(b, mipsu_fmt_1r, e.mnem, rd);
-    case MIPSU_OP_FMT_RS_RT:
-        return sprintf(b, mipsu_fmt_2r, e.mnem, rs, rt);
-    case MIPSU_OP_FMT_RD_RT_RS:
-        return sprintf(b, mipsu_fmt_3r, e.mnem, rd, rt, rs);
-    case MIPSU_OP_FMT_RD_RT_SH:
-        return sprintf(b, mipsu_fmt_2r_hex2, e.mnem, rd, rt, f.sh);
-    case MIPSU_OP_FMT_RD_RS_RT:
-        return sprintf(b, mipsu_fmt_3r, e.mnem, rd, rs, rt);
+size_t mipsu_disasm(mipsu_word_t w, char* b, mipsu_ctx_t c) {
+    const size_t rw = mipsu_reg_width;
+
+    const mipsu_op_entry_t* e = mipsu_instr(w);
+    const char*             t;
+
+    char* p = b;
+
+    if (!e->fmt) e = &mipsu_word_entry;
+
+    memcpy(p, e->mnem, e->len);
+    p += e->len;
+
+    if (e->len < mipsu_mnem_width)
+        p = mipsu_put_chr(p, ' ', mipsu_mnem_width - e->len);
+
+    /* jalr through $ra is written as its one operand form */
+    t = mipsu_tmpl_lut[e->fmt];
+    if (e->fmt == MIPSU_OP_FMT_RD_RS && mipsu_rd(w) == mipsu_reg_ra)
+        t = mipsu_tmpl_lut[MIPSU_OP_FMT_RS];
+
+    for (; *t; ++t) {
+        switch (*t) {
+        case 's':
+            p = mipsu_put_reg(p, mipsu_rs(w), rw, c);
+            break;
+        case 't':
+            p = mipsu_put_reg(p, mipsu_rt(w), rw, c);
+            break;
+        case 'd':
+            p = mipsu_put_reg(p, mipsu_rd(w), rw, c);
+            break;
+        case 'S':
+            p = mipsu_put_reg(p, mipsu_rs(w), 0, c);
+            break;
+        case 'h':
+            p = mipsu_put_hex(p, mipsu_sh(w), 2);
+            break;
+        case 'i':
+            p = mipsu_put_imm(p, mipsu_imm(w), c);
+            break;
+        case 'o':
+            p = mipsu_put_hex(p, w & mipsu_16bit_mask, 4);
+            break;
+        case 'a':
+            p = mipsu_put_hex(p, mipsu_addr(w), 8);
+            break;
+        case 'w':
+            p = mipsu_put_hex(p, w, 8);
+            break;
+        default:
+            *p++ = *t;
+        }
+    }
 
-    case MIPSU_OP_FMT_RS_IMM:
-        return sprintf(b, fmt_1r_imm, e.mnem, rs, f.imm);
-    case MIPSU_OP_FMT_RT_IMM:
-        return sprintf(b, fmt_1r_imm, e.mnem, rt, f.imm);
-    case MIPSU_OP_FMT_RT_IMM_RS:
-        return sprintf(b, mipsu_fmt_r_hex4_r, e.mnem, rt, f.imm, rs);
-    case MIPSU_OP_FMT_RT_RS_IMM:
-        return sprintf(b, fmt_2r_imm, e.mnem, rt, rs, f.imm);
-    case MIPSU_OP_FMT_RS_RT_IMM:
-        return sprintf(b, fmt_2r_imm, e.mnem, rs, rt, f.imm);
+    *p++ = '\n';
+    *p   = 0;
 
-    case MIPSU_OP_FMT_ADDR:
-        return sprintf(b, mipsu_fmt_hex8, e.mnem, f.addr);
-    }
+    return p - b;
 }
 
 /* === Assembly === */
 
-static mipsu_result_t mipsu_asm(size_t n, const char** a, mipsu_field_t* f,
-                                mipsu_ctx_t c) {
+static mipsu_result_t mipsu_asm_args(size_t n, const char** a,
+                                     mipsu_field_t* f, mipsu_ctx_t c) {
     mipsu_op_entry_t e;
     mipsu_result_t   r;
 
     memset(f, 0, sizeof(mipsu_field_t));
 
+    if (!n) return MIPSU_RESULT_BAD_OP;
+
     r = mipsu_parse_op(a[0], &e, &f->op);
     if (r) return r;
 
@@ -1172,6 +2525,10 @@ static mipsu_result_t mipsu_asm(size_t n, const char** a, mipsu_field_t* f,
         return mipsu_parse_1r(n, a, &f->rd, c);
     case MIPSU_OP_FMT_RS_RT:
         return mipsu_parse_2r(n, a, &f->rs, &f->rt, c);
+    case MIPSU_OP_FMT_RD_RS:
+        if (n != 2) return mipsu_parse_2r(n, a, &f->rd, &f->rs, c);
+        f->rd = mipsu_reg_ra;
+        return mipsu_parse_1r(n, a, &f->rs, c);
     case MIPSU_OP_FMT_RD_RS_RT:
         return mipsu_parse_3r(n, a, &f->rd, &f->rs, &f->rt, c);
     case MIPSU_OP_FMT_RD_RT_RS:
@@ -1196,162 +2553,5782 @@ static mipsu_result_t mipsu_asm(size_t n, const char** a, mipsu_field_t* f,
     }
 }
 
-/* === Dumping === */
+mipsu_result_t mipsu_asm(const char* s, mipsu_field_t* f, mipsu_ctx_t c) {
+    char        b[1024];
+    const char* a[4] = {};
+    size_t      n;
+
+    mipsu_result_t r = mipsu_parse_asm(s, b, sizeof(b), a, &n);
+
+    if (r) return r;
+
+    return mipsu_asm_args(n, a, f, c);
+}
+
+/* one AND and compare for words that are fine, the usual case */
+mipsu_result_t mipsu_verify(mipsu_word_t w) {
+    size_t i = mipsu_instr_idx(w);
+
+    if (!(w & ~mipsu_legal_lut[i])) return MIPSU_RESULT_OK;
+
+    return mipsu_instr_lut[i].len ? MIPSU_RESULT_BAD_ENCODING
+                                  : MIPSU_RESULT_BAD_INSTR;
+}
+
+const char* mipsu_result_str(mipsu_result_t r) { return mipsu_res_msg_lut[r]; }
+
+#ifndef MIPSU_LIB
+
+/* === Dumping === */
+
+/* a full buffer with no stream to flush to starts over, counting the loss */
+static char* mipsu_dump_begin(mipsu_cli_t c) {
+    if (c.b->cap - c.b->n < mipsu_line_max) mipsu_flush(c);
+
+    if (c.b->cap - c.b->n < mipsu_line_max) {
+        c.b->lost += c.b->n;
+        c.b->n = 0;
+    }
+
+    return c.b->data + c.b->n;
+}
+
+static void mipsu_dump_end(const char* p, mipsu_cli_t c) {
+    c.b->n = p - c.b->data;
+}
+
+static void mipsu_dump_field(mipsu_word_t w, mipsu_field_t f, mipsu_cli_t c) {
+    mipsu_result_t r = mipsu_verify(w);
+    char*          p;
+
+    if (r) mipsu_wrnr(r, c);
+
+    p = mipsu_dump_begin(c);
+
+    p += mipsu_fmt_field(w, f, p, mipsu_lib(c));
+    mipsu_dump_end(p, c);
+}
+
+static void mipsu_dump_word(mipsu_word_t w, mipsu_cli_t c) {
+    char* p = mipsu_dump_begin(c);
+
+    if (mipsu_get_flag(c, MIPSU_FLAG_RAW)) {
+        if (mipsu_swapped(c)) w = mipsu_swap(w);
+        memcpy(p, &w, mipsu_word_size);
+        p += mipsu_word_size;
+    } else {
+        p    = mipsu_put_hex(p, w, 8);
+        *p++ = '\n';
+    }
+
+    mipsu_dump_end(p, c);
+}
+
+/* raw runs are copied into the buffer whole, as much as fits at a time */
+static void mipsu_dump_words(const mipsu_word_t* w, size_t n, mipsu_cli_t c) {
+    mipsu_word_t v;
+    size_t       i, k;
+    char*        p;
+
+    if (!mipsu_get_flag(c, MIPSU_FLAG_RAW)) {
+        for (i = 0; i < n; ++i)
+            mipsu_dump_word(w[i], c);
+        return;
+    }
+
+    for (; n; n -= k, w += k) {
+        if (c.b->cap - c.b->n < mipsu_word_size) mipsu_flush(c);
+
+        p = c.b->data + c.b->n;
+        k = (c.b->cap - c.b->n) / mipsu_word_size;
+        if (k > n) k = n;
+
+        memcpy(p, w, k * mipsu_word_size);
+        c.b->n += k * mipsu_word_size;
+
+        for (i = 0; mipsu_swapped(c) && i < k; ++i) {
+            v = mipsu_swap(w[i]);
+            memcpy(p + i * mipsu_word_size, &v, mipsu_word_size);
+        }
+    }
+}
+
+static void mipsu_dump_mnem(mipsu_word_t w, mipsu_cli_t c) {
+    char* p = mipsu_dump_begin(c);
+
+    p += mipsu_disasm(w, p, mipsu_lib(c));
+    mipsu_dump_end(p, c);
+}
+
+static void mipsu_dump_instr(mipsu_word_t w, mipsu_cli_t c) {
+    char* p = mipsu_dump_begin(c);
+
+    p = mipsu_put_hex(p, w, 8);
+    p = mipsu_put_chr(p, ' ', 2);
+    p += mipsu_disasm(w, p, mipsu_lib(c));
+    mipsu_dump_end(p, c);
+}
+
+static char* mipsu_put_jkey(char* p, const char* k) {
+    *p++ = ',';
+    *p++ = '"';
+    p    = mipsu_put_str(p, k);
+    *p++ = '"';
+    *p++ = ':';
+
+    return p;
+}
+
+static char* mipsu_put_jstr(char* p, const char* s, size_t n) {
+    *p++ = '"';
+    memcpy(p, s, n);
+    p += n;
+    *p++ = '"';
+
+    return p;
+}
+
+/* disasm without its padding: no runs of spaces, none inside operands */
+static char* mipsu_put_jasm(char* p, mipsu_word_t w, mipsu_cli_t c) {
+    char* s = p + 1;
+    char* e = s + mipsu_disasm(w, s, mipsu_lib(c));
+    char* b = s;
+    char* q;
+
+    for (q = b; q < e; ++q)
+        if (*q != ' ' && *q != '\n')
+            *s++ = *q;
+        else if (*q == ' ' && s > b && s[-1] != ' ' && s[-1] != '(' &&
+                 q + 1 < e && strchr(", )\n", q[1]) == NULL)
+            *s++ = ' ';
+
+    *p = '"';
+    *s = '"';
+
+    return s + 1;
+}
+
+/*
+ * One JSON object per line: where the word was, the word, its fields as
+ * mipsu_decode gives them, its mnemonic (null if unknown) and its disasm.
+ */
+static void mipsu_dump_json(uint32_t a, mipsu_word_t w, mipsu_cli_t c) {
+    const mipsu_op_entry_t* e = mipsu_instr(w);
+    mipsu_field_t           f = mipsu_decode(w);
+    char*                   p = mipsu_dump_begin(c);
+
+    p = mipsu_put_str(p, "{\"at\":");
+    p = mipsu_put_cnt(p, a, 0);
+    p = mipsu_put_jkey(p, "word");
+    p = mipsu_put_cnt(p, w, 0);
+    p = mipsu_put_jkey(p, "type");
+    p = mipsu_put_jstr(p, mipsu_type_lut + f.type, 1);
+    p = mipsu_put_jkey(p, "op");
+    p = mipsu_put_dec(p, f.op, 0);
+
+    switch (f.type) {
+    case MIPSU_TYPE_R:
+        p = mipsu_put_dec(mipsu_put_jkey(p, "rs"), f.rs, 0);
+        p = mipsu_put_dec(mipsu_put_jkey(p, "rt"), f.rt, 0);
+        p = mipsu_put_dec(mipsu_put_jkey(p, "rd"), f.rd, 0);
+        p = mipsu_put_dec(mipsu_put_jkey(p, "sh"), f.sh, 0);
+        p = mipsu_put_dec(mipsu_put_jkey(p, "fn"), f.fn, 0);
+        break;
+    case MIPSU_TYPE_I:
+        p = mipsu_put_dec(mipsu_put_jkey(p, "rs"), f.rs, 0);
+        p = mipsu_put_dec(mipsu_put_jkey(p, "rt"), f.rt, 0);
+        p = mipsu_put_dec(mipsu_put_jkey(p, "imm"), f.imm, 0);
+        break;
+    case MIPSU_TYPE_J:
+        p = mipsu_put_dec(mipsu_put_jkey(p, "addr"), f.addr, 0);
+        break;
+    }
+
+    p = mipsu_put_jkey(p, "mnem");
+    p = e->len ? mipsu_put_jstr(p, e->mnem, e->len) : mipsu_put_str(p, "null");
+    p = mipsu_put_jkey(p, "asm");
+    p = mipsu_put_jasm(p, w, c);
+    p = mipsu_put_jkey(p, "canon");
+    p = mipsu_put_str(p, f.res ? "false}\n" : "true}\n");
+
+    mipsu_dump_end(p, c);
+}
+
+static void mipsu_dump_record(uint32_t a, mipsu_word_t w, mipsu_cli_t c) {
+    mipsu_record_t r = {};
+    char*          p = mipsu_dump_begin(c);
+
+    r.addr  = a;
+    r.word  = w;
+    r.imm   = mipsu_imm(w);
+    r.op    = mipsu_op(w);
+    r.rs    = mipsu_rs(w);
+    r.rt    = mipsu_rt(w);
+    r.rd    = mipsu_rd(w);
+    r.sh    = mipsu_sh(w);
+    r.fn    = mipsu_fn(w);
+    r.type  = mipsu_op_lut[r.op].type;
+    r.instr = mipsu_instr_idx(w);
+    r.res   = mipsu_verify(w);
+
+    memcpy(p, &r, sizeof(mipsu_record_t));
+    mipsu_dump_end(p + sizeof(mipsu_record_t), c);
+}
+
+/* --format=jsonl and bin, false if the word is left to the text dumps */
+static bool_t mipsu_dump_fmt(uint32_t a, mipsu_word_t w, mipsu_cli_t c) {
+    if (mipsu_get_flag(c, MIPSU_FLAG_JSONL))
+        mipsu_dump_json(a, w, c);
+    else if (mipsu_get_flag(c, MIPSU_FLAG_BIN))
+        mipsu_dump_record(a, w, c);
+    else
+        return false;
+
+    return true;
+}
+
+static void mipsu_dump_decoded(mipsu_word_t w, mipsu_cli_t c) {
+    mipsu_field_t f = mipsu_decode(w);
+
+    if (!mipsu_dump_fmt(mipsu_text_base, w, c)) mipsu_dump_field(w, f, c);
+}
+
+static void mipsu_dump_encoded(mipsu_field_t f, mipsu_cli_t c) {
+    mipsu_word_t w = mipsu_encode(f);
+
+    if (mipsu_get_flag(c, MIPSU_FLAG_QUIET))
+        mipsu_dump_word(w, c);
+    else
+        mipsu_dump_field(w, f, c);
+}
+
+/* a is where the word is, which only the machine formats write */
+static void mipsu_dump_disasm(uint32_t a, mipsu_word_t w, mipsu_cli_t c) {
+    if (mipsu_dump_fmt(a, w, c)) return;
+
+    if (mipsu_get_flag(c, MIPSU_FLAG_QUIET))
+        mipsu_dump_mnem(w, c);
+    else
+        mipsu_dump_instr(w, c);
+}
+
+/* with --strict, unknown and non-canonical words fail disassembly */
+static mipsu_result_t mipsu_check_words(const mipsu_word_t* w, size_t n,
+                                        mipsu_cli_t c) {
+    mipsu_result_t r;
+    size_t         i;
+
+    if (!mipsu_get_flag(c, MIPSU_FLAG_STRICT)) return MIPSU_RESULT_OK;
+
+    for (i = 0; i < n; ++i)
+        if ((r = mipsu_verify(w[i]))) return r;
+
+    return MIPSU_RESULT_OK;
+}
+
+/* like mipsu_dump_disasm, prefixed with the word's address */
+static void mipsu_dump_at(uint32_t a, mipsu_word_t w, mipsu_cli_t c) {
+    char* p;
+
+    if (mipsu_dump_fmt(a, w, c)) return;
+
+    if (mipsu_get_flag(c, MIPSU_FLAG_QUIET)) {
+        mipsu_dump_mnem(w, c);
+        return;
+    }
+
+    p = mipsu_dump_begin(c);
+    p = mipsu_put_hex(p, a, 8);
+    p = mipsu_put_chr(p, ' ', 2);
+    p = mipsu_put_hex(p, w, 8);
+    p = mipsu_put_chr(p, ' ', 2);
+    p += mipsu_disasm(w, p, mipsu_lib(c));
+    mipsu_dump_end(p, c);
+}
+
+/* cut to fit the line the dump buffer guarantees */
+static void mipsu_dump_label(const char* s, mipsu_cli_t c) {
+    size_t n = strlen(s);
+    char*  p = mipsu_dump_begin(c);
+
+    if (n > mipsu_line_max - 2) n = mipsu_line_max - 2;
+
+    memcpy(p, s, n);
+    p += n;
+    *p++ = ':';
+    *p++ = '\n';
+    mipsu_dump_end(p, c);
+}
+
+static void mipsu_dump_asm_word(mipsu_word_t w, mipsu_cli_t c) {
+    if (mipsu_get_flag(c, MIPSU_FLAG_QUIET))
+        mipsu_dump_word(w, c);
+    else
+        mipsu_dump_instr(w, c);
+}
+
+static void mipsu_dump_asm(mipsu_field_t f, mipsu_cli_t c) {
+    mipsu_dump_asm_word(mipsu_encode(f), c);
+}
+
+static const size_t mipsu_cnt_width = 12;
+
+static char* mipsu_put_stat(char* p, const char* k, uint64_t v) {
+    p    = mipsu_put_pad(p, k, mipsu_mnem_width);
+    p    = mipsu_put_cnt(p, v, mipsu_cnt_width);
+    *p++ = '\n';
+
+    return p;
+}
+
+static void mipsu_dump_stats(const mipsu_stats_t* s, mipsu_cli_t c) {
+    uint64_t n = 0, u = 0, t[3] = {};
+    char     k[2] = {};
+    char*    p;
+    size_t   i;
+
+    for (i = 0; i < 128; ++i) {
+        n += s->instr[i];
+
+        if (mipsu_instr_lut[i].mnem)
+            t[mipsu_instr_lut[i].type] += s->instr[i];
+        else
+            u += s->instr[i];
+    }
+
+    p = mipsu_dump_begin(c);
+    p = mipsu_put_stat(p, "words", n);
+    p = mipsu_put_stat(p, "unknown", u);
+    p = mipsu_put_stat(p, "legal", s->bad - u);
+
+    for (i = 0; i < 3; ++i) {
+        *k = mipsu_type_lut[i];
+        p  = mipsu_put_stat(p, k, t[i]);
+    }
+
+    p = mipsu_put_str(p, "--------\n");
+    mipsu_dump_end(p, c);
+
+    for (i = 0; i < 128; ++i) {
+        if (!s->instr[i] || !mipsu_instr_lut[i].mnem) continue;
+
+        p = mipsu_dump_begin(c);
+        p = mipsu_put_stat(p, mipsu_instr_lut[i].mnem, s->instr[i]);
+        mipsu_dump_end(p, c);
+    }
+
+    p = mipsu_dump_begin(c);
+    p = mipsu_put_str(p, "--------\n");
+    p = mipsu_put_pad(p, "reg", mipsu_mnem_width);
+    p = mipsu_put_chr(p, ' ', mipsu_cnt_width - 5);
+    p = mipsu_put_str(p, "reads");
+    p = mipsu_put_chr(p, ' ', mipsu_cnt_width - 6);
+    p = mipsu_put_str(p, "writes\n");
+    mipsu_dump_end(p, c);
+
+    for (i = 0; i < 32; ++i) {
+        p    = mipsu_dump_begin(c);
+        p    = mipsu_put_reg(p, i, mipsu_mnem_width - 1, mipsu_lib(c));
+        p    = mipsu_put_cnt(p, s->reads[i], mipsu_cnt_width);
+        p    = mipsu_put_cnt(p, s->writes[i], mipsu_cnt_width);
+        *p++ = '\n';
+        mipsu_dump_end(p, c);
+    }
+}
+
+static void mipsu_dump_cpu(const mipsu_cpu_t* m, mipsu_cli_t c) {
+    const char* k[] = {"pc", "hi", "lo"};
+    uint32_t    v[] = {m->cur, m->hi, m->lo};
+    char*       p;
+    size_t      i;
+
+    if (mipsu_get_flag(c, MIPSU_FLAG_QUIET)) return;
+
+    p    = mipsu_dump_begin(c);
+    p    = mipsu_put_pad(p, "exit", mipsu_mnem_width);
+    p    = mipsu_put_dec(p, m->code, mipsu_cnt_width);
+    *p++ = '\n';
+    p    = mipsu_put_stat(p, "instrs", m->n);
+    p    = mipsu_put_str(p, "--------\n");
+
+    for (i = 0; i < 3; ++i) {
+        p    = mipsu_put_pad(p, k[i], mipsu_mnem_width);
+        p    = mipsu_put_hex(p, v[i], 8);
+        *p++ = '\n';
+    }
+
+    mipsu_dump_end(p, c);
+
+    for (i = 0; i < 32; ++i) {
+        p    = mipsu_dump_begin(c);
+        p    = mipsu_put_reg(p, i, mipsu_mnem_width - 1, mipsu_lib(c));
+        p    = mipsu_put_hex(p, m->r[i], 8);
+        *p++ = '\n';
+        mipsu_dump_end(p, c);
+    }
+}
+
+/* === Jobs === */
+
+static void* mipsu_job_disasm(void* p) {
+    mipsu_job_t* j = p;
+    size_t       i;
+
+    for (i = 0; i < j->n; ++i)
+        mipsu_dump_disasm(j->a + i * mipsu_word_size, j->w[i], j->c);
+
+    return NULL;
+}
+
+static void* mipsu_job_stats(void* p) {
+    mipsu_job_t* j = p;
+
+    mipsu_stats_add(j->w, j->n, &j->s);
+
+    return NULL;
+}
+
+/*
+ * Starts k jobs on consecutive slices of m words each, out of n at a. Jobs
+ * whose thread fails to start run inline, so every slice gets done.
+ */
+static void mipsu_jobs_start(mipsu_job_t* v, size_t k, const mipsu_word_t* w,
+                             size_t n, uint32_t a, size_t m,
+                             void* (*f)(void*)) {
+    size_t i;
+
+    for (i = 0; i < k; ++i) {
+        v[i].w   = w + (n < i * m ? n : i * m);
+        v[i].n   = n < (i + 1) * m ? n - (v[i].w - w) : m;
+        v[i].a   = a + (v[i].w - w) * mipsu_word_size;
+        v[i].b.n = 0;
+
+        v[i].live = !pthread_create(&v[i].t, NULL, f, v + i);
+        if (!v[i].live) f(v + i);
+    }
+}
+
+static void mipsu_jobs_join(mipsu_job_t* v, size_t k, mipsu_cli_t c) {
+    size_t i;
+
+    for (i = 0; i < k; ++i) {
+        if (v[i].live) pthread_join(v[i].t, NULL);
+
+        mipsu_flush(c);
+        fwrite(v[i].b.data, 1, v[i].b.n, c.o);
+    }
+}
+
+/*
+ * Disassembles n words on c.jobs threads. Every round gives each job a
+ * slice of mipsu_job_words, and the jobs of the next round are started
+ * before the output of the current one is written, in order.
+ */
+static mipsu_result_t mipsu_jobs_disasm(const mipsu_word_t* w, size_t n,
+                                        uint32_t a, mipsu_cli_t c) {
+    mipsu_job_t*   v;
+    mipsu_result_t r = MIPSU_RESULT_OK;
+    size_t         i, k = c.jobs, round = k * mipsu_job_words;
+    bool_t         cur = 0;
+
+    v = calloc(2 * k, sizeof(mipsu_job_t));
+    if (!v) return MIPSU_RESULT_BUFF_OVERFLOW;
+
+    for (i = 0; i < 2 * k; ++i) {
+        v[i].b.cap  = mipsu_job_words * mipsu_line_max;
+        v[i].b.data = malloc(v[i].b.cap);
+        v[i].c      = c;
+        v[i].c.o    = NULL;
+        v[i].c.b    = &v[i].b;
+
+        if (!v[i].b.data) r = MIPSU_RESULT_BUFF_OVERFLOW;
+    }
+
+    for (i = 0; !r && i < n; i += round) {
+        mipsu_jobs_start(v + cur * k,
+                         k,
+                         w + i,
+                         n - i < round ? n - i : round,
+                         a + i * mipsu_word_size,
+                         mipsu_job_words,
+                         mipsu_job_disasm);
+
+        if (i) mipsu_jobs_join(v + !cur * k, k, c);
+
+        cur = !cur;
+    }
+
+    if (i) mipsu_jobs_join(v + !cur * k, k, c);
+
+    for (i = 0; i < 2 * k; ++i)
+        free(v[i].b.data);
+    free(v);
+
+    return r;
+}
+
+/* a is the address of w[0], as loaded by run */
+static mipsu_result_t mipsu_disasm_words(const mipsu_word_t* w, size_t n,
+                                         uint32_t a, mipsu_cli_t c) {
+    mipsu_result_t r = mipsu_check_words(w, n, c);
+    size_t         i;
+
+    if (r) return r;
+
+    if (c.jobs > 1) return mipsu_jobs_disasm(w, n, a, c);
+
+    for (i = 0; i < n; ++i)
+        mipsu_dump_disasm(a + i * mipsu_word_size, w[i], c);
+
+    return MIPSU_RESULT_OK;
+}
+
+/* one round over all words, each job counting into its own stats */
+static mipsu_result_t mipsu_jobs_stats(mipsu_job_t* v, size_t k,
+                                       const mipsu_word_t* w, size_t n) {
+    size_t i;
+
+    mipsu_jobs_start(v, k, w, n, 0, (n + k - 1) / k, mipsu_job_stats);
+
+    for (i = 0; i < k; ++i)
+        if (v[i].live) pthread_join(v[i].t, NULL);
+
+    return MIPSU_RESULT_OK;
+}
+
+static void mipsu_stats_merge(mipsu_stats_t* s, const mipsu_stats_t* a) {
+    size_t i;
+
+    for (i = 0; i < 128; ++i)
+        s->instr[i] += a->instr[i];
+
+    s->bad += a->bad;
+
+    for (i = 0; i < 32; ++i) {
+        s->reads[i] += a->reads[i];
+        s->writes[i] += a->writes[i];
+    }
+}
+
+/* === Mapping === */
+
+/* regular files, which alone can be mapped */
+static bool_t mipsu_seekable(file_t* f) {
+    struct stat st;
+
+    return !fstat(fileno(f), &st) && S_ISREG(st.st_mode);
+}
+
+static mipsu_result_t mipsu_file_size(file_t* f, size_t* s) {
+    struct stat st;
+
+    if (fstat(fileno(f), &st) || !S_ISREG(st.st_mode))
+        return MIPSU_RESULT_READ_FILE;
+
+    *s = st.st_size;
+
+    return MIPSU_RESULT_OK;
+}
+
+/* private and writable, so the emulator can store to text it maps */
+static mipsu_result_t mipsu_map(file_t* f, size_t o, size_t n,
+                                mipsu_map_t* m) {
+    int   b = PROT_READ | PROT_WRITE;
+    void* p = mmap(NULL, n, b, MAP_PRIVATE, fileno(f), (off_t)o);
+
+    if (p == MAP_FAILED) return MIPSU_RESULT_MAP_FILE;
+
+    m->data = p;
+    m->size = n;
+
+    return MIPSU_RESULT_OK;
+}
+
+static void mipsu_unmap(mipsu_map_t m) { munmap((void*)m.data, m.size); }
+
+/* raw words in host order; native files are never touched, the rest once */
+static mipsu_result_t mipsu_map_raw(size_t o, size_t n, mipsu_map_t* m,
+                                    mipsu_cli_t c) {
+    mipsu_result_t r = mipsu_map(c.f, o, n, m);
+
+    if (!r && mipsu_swapped(c))
+        mipsu_swap_words((mipsu_word_t*)m->data, n / mipsu_word_size);
+
+    return r;
+}
+
+/* pipes and terminals, read whole into the heap */
+static mipsu_result_t mipsu_src_read(file_t* f, mipsu_src_t* s) {
+    size_t cap = 0, k;
+
+    s->data = NULL;
+    s->size = 0;
+    s->heap = true;
+
+    do {
+        while (cap - s->size < 4096 + 1)
+            if (!mipsu_grow((void**)&s->data, cap, &cap, 1))
+                return MIPSU_RESULT_BUFF_OVERFLOW;
+
+        k = fread(s->data + s->size, 1, cap - s->size - 1, f);
+        s->size += k;
+    } while (k);
+
+    if (ferror(f)) return MIPSU_RESULT_READ_FILE;
+
+    s->data[s->size] = 0;
+
+    return MIPSU_RESULT_OK;
+}
+
+/* pipes, read whole into an anonymous mapping so files and pipes unmap alike */
+static mipsu_result_t mipsu_map_pipe(file_t* f, mipsu_map_t* m) {
+    int            b = PROT_READ | PROT_WRITE;
+    mipsu_src_t    s;
+    mipsu_result_t r = mipsu_src_read(f, &s);
+    void*          p;
+
+    m->data = NULL;
+    m->size = 0;
+
+    if (!r && s.size) {
+        p = mmap(NULL, s.size, b, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (p != MAP_FAILED) {
+            memcpy(p, s.data, s.size);
+            m->data = p;
+            m->size = s.size;
+        } else
+            r = MIPSU_RESULT_MAP_FILE;
+    }
+
+    free(s.data);
+
+    return r;
+}
+
+/* raw words of the whole input; nothing is mapped when it is empty */
+static mipsu_result_t mipsu_map_whole(mipsu_map_t* m, mipsu_cli_t c) {
+    mipsu_result_t r;
+    size_t         n;
+
+    m->data = NULL;
+    m->size = 0;
+
+    if (mipsu_seekable(c.f)) {
+        r = mipsu_file_size(c.f, &n);
+        return r || !n ? r : mipsu_map_raw(0, n, m, c);
+    }
+
+    r = mipsu_map_pipe(c.f, m);
+
+    if (!r && m->data && mipsu_swapped(c))
+        mipsu_swap_words((mipsu_word_t*)m->data, m->size / mipsu_word_size);
+
+    return r;
+}
+
+/*
+ * Files are mapped over a reserved anonymous run one byte longer, so the
+ * byte past the end reads zero even when the size is a page multiple.
+ */
+static mipsu_result_t mipsu_src_open(file_t* f, mipsu_src_t* s) {
+    int    b = PROT_READ | PROT_WRITE;
+    void*  p;
+    size_t n;
+
+    if (mipsu_file_size(f, &n)) return mipsu_src_read(f, s);
+
+    p = mmap(NULL, n + 1, b, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return MIPSU_RESULT_MAP_FILE;
+
+    if (n && mmap(p, n, b, MAP_PRIVATE | MAP_FIXED, fileno(f), 0) ==
+                 MAP_FAILED) {
+        munmap(p, n + 1);
+        return MIPSU_RESULT_MAP_FILE;
+    }
+
+    s->data = p;
+    s->size = n;
+    s->heap = false;
+
+    return MIPSU_RESULT_OK;
+}
+
+static void mipsu_src_close(mipsu_src_t s) {
+    if (s.heap)
+        free(s.data);
+    else if (s.data)
+        munmap(s.data, s.size + 1);
+}
+
+/* === Streaming === */
+
+static void* mipsu_stream_fill(void* p) {
+    mipsu_stream_t* s = p;
+
+    s->n[!s->cur] = fread(s->b[!s->cur], 1, mipsu_stream_block, s->f);
+
+    return NULL;
+}
+
+static void mipsu_stream_close(mipsu_stream_t* s) {
+    if (s->busy) pthread_join(s->t, NULL);
+    if (s->m.data) mipsu_unmap(s->m);
+
+    free(s->b[0]);
+    free(s->b[1]);
+}
+
+/* a pipe's first block is read here, so the first call to next has it */
+static mipsu_result_t mipsu_stream_open(mipsu_stream_t* s, file_t* f) {
+    memset(s, 0, sizeof(mipsu_stream_t));
+
+    s->f    = f;
+    s->pipe = !mipsu_seekable(f);
+
+    if (!s->pipe) return mipsu_file_size(f, &s->z);
+
+    s->b[0] = malloc(mipsu_stream_block);
+    s->b[1] = malloc(mipsu_stream_block);
+
+    if (!s->b[0] || !s->b[1]) return MIPSU_RESULT_BUFF_OVERFLOW;
+
+    mipsu_stream_fill(s);
+
+    return MIPSU_RESULT_OK;
+}
+
+static mipsu_result_t mipsu_stream_map(mipsu_stream_t* s, mipsu_word_t** w,
+                                       size_t* n, mipsu_cli_t c) {
+    mipsu_result_t r;
+    size_t         k = s->z - s->o;
+
+    if (k > mipsu_map_window) k = mipsu_map_window;
+    if (s->m.data) mipsu_unmap(s->m);
+
+    s->m.data = NULL;
+
+    if (!k) {
+        s->rest = s->z % mipsu_word_size;
+        return MIPSU_RESULT_OK;
+    }
+
+    r = mipsu_map_raw(s->o, k, &s->m, c);
+    if (r) return r;
+
+    s->o += k;
+    *w = (mipsu_word_t*)s->m.data;
+    *n = k / mipsu_word_size;
+
+    return MIPSU_RESULT_OK;
+}
+
+/*
+ * The next n words, in host order, valid until the next call; none at the
+ * end. A pipe is done with the block before, so the read after this one
+ * goes there, on a thread, or in place when none can be started.
+ */
+static mipsu_result_t mipsu_stream_next(mipsu_stream_t* s, mipsu_word_t** w,
+                                        size_t* n, mipsu_cli_t c) {
+    size_t k;
+
+    *n = 0;
+
+    if (!s->pipe) return mipsu_stream_map(s, w, n, c);
+
+    if (s->busy) pthread_join(s->t, NULL);
+
+    s->busy = false;
+
+    if (s->done) return MIPSU_RESULT_OK;
+
+    s->cur = !s->cur;
+    k      = s->n[s->cur];
+
+    if (k < mipsu_stream_block) {
+        s->done = true;
+        s->rest = k % mipsu_word_size;
+
+        if (ferror(s->f)) return MIPSU_RESULT_READ_FILE;
+    } else if (pthread_create(&s->t, NULL, mipsu_stream_fill, s)) {
+        mipsu_stream_fill(s);
+    } else {
+        s->busy = true;
+    }
+
+    *w = (mipsu_word_t*)s->b[s->cur];
+    *n = k / mipsu_word_size;
+
+    if (mipsu_swapped(c)) mipsu_swap_words(*w, *n);
+
+    return MIPSU_RESULT_OK;
+}
+
+/* === ELF === */
+
+/* the n bytes at offset o of the file, NULL past its end */
+static const uint8_t* mipsu_elf_at(const mipsu_elf_t* e, uint32_t o,
+                                   uint32_t n) {
+    if (o > e->map.size || n > e->map.size - o) return NULL;
+
+    return (const uint8_t*)e->map.data + o;
+}
+
+static uint16_t mipsu_swap16(uint16_t h) { return h >> 8 | h << 8; }
+
+/* section and program headers are all words */
+static void mipsu_elf_shdr(const mipsu_elf_t* e, size_t i,
+                           mipsu_elf_shdr_t* s) {
+    memcpy(s, mipsu_elf_at(e, e->h.shoff + i * e->h.shentsize, 0),
+           sizeof(mipsu_elf_shdr_t));
+
+    if (e->swap)
+        mipsu_swap_words((mipsu_word_t*)s,
+                         sizeof(mipsu_elf_shdr_t) / mipsu_word_size);
+}
+
+static void mipsu_elf_phdr(const mipsu_elf_t* e, size_t i,
+                           mipsu_elf_phdr_t* p) {
+    memcpy(p, mipsu_elf_at(e, e->h.phoff + i * e->h.phentsize, 0),
+           sizeof(mipsu_elf_phdr_t));
+
+    if (e->swap)
+        mipsu_swap_words((mipsu_word_t*)p,
+                         sizeof(mipsu_elf_phdr_t) / mipsu_word_size);
+}
+
+static void mipsu_elf_swap_hdr(mipsu_elf_hdr_t* h) {
+    h->type      = mipsu_swap16(h->type);
+    h->machine   = mipsu_swap16(h->machine);
+    h->version   = mipsu_swap(h->version);
+    h->entry     = mipsu_swap(h->entry);
+    h->phoff     = mipsu_swap(h->phoff);
+    h->shoff     = mipsu_swap(h->shoff);
+    h->flags     = mipsu_swap(h->flags);
+    h->ehsize    = mipsu_swap16(h->ehsize);
+    h->phentsize = mipsu_swap16(h->phentsize);
+    h->phnum     = mipsu_swap16(h->phnum);
+    h->shentsize = mipsu_swap16(h->shentsize);
+    h->shnum     = mipsu_swap16(h->shnum);
+    h->shstrndx  = mipsu_swap16(h->shstrndx);
+}
+
+/*
+ * Words of the n bytes at offset o, turned to host order in place if the
+ * file uses the other one; NULL past the end of the file or if unaligned.
+ */
+static mipsu_word_t* mipsu_elf_words(const mipsu_elf_t* e, uint32_t o,
+                                     uint32_t n) {
+    uint8_t* b = (uint8_t*)mipsu_elf_at(e, o, n);
+
+    if (!b || (o & 3)) return NULL;
+
+    if (e->swap) mipsu_swap_words((mipsu_word_t*)b, n / mipsu_word_size);
+
+    return (mipsu_word_t*)b;
+}
+
+static int mipsu_sym_cmp(const void* a, const void* b) {
+    uint32_t x = ((const mipsu_sym_t*)a)->addr;
+    uint32_t y = ((const mipsu_sym_t*)b)->addr;
+
+    return (x > y) - (x < y);
+}
+
+/* defined code, data and untyped symbols; sections and files are left out */
+static mipsu_result_t mipsu_elf_syms(mipsu_elf_t* e) {
+    mipsu_elf_shdr_t s, t;
+    mipsu_elf_sym_t  y;
+    const uint8_t*   b = NULL;
+    const char*      str;
+    size_t           i, n = 0;
+
+    for (i = 0; i < e->h.shnum && !b; ++i) {
+        mipsu_elf_shdr(e, i, &s);
+
+        if (s.type != mipsu_elf_sht_symtab || s.link >= e->h.shnum) continue;
+
+        mipsu_elf_shdr(e, s.link, &t);
+
+        str = (const char*)mipsu_elf_at(e, t.off, t.size);
+        b   = mipsu_elf_at(e, s.off, s.size);
+        n   = s.size / sizeof(mipsu_elf_sym_t);
+
+        if (!str || !b) return MIPSU_RESULT_BAD_ELF;
+    }
+
+    if (!n) return MIPSU_RESULT_OK;
+
+    e->syms = malloc(n * sizeof(mipsu_sym_t));
+    if (!e->syms) return MIPSU_RESULT_BUFF_OVERFLOW;
+
+    for (i = 0; i < n; ++i) {
+        memcpy(&y, b + i * sizeof(mipsu_elf_sym_t), sizeof(y));
+
+        if (e->swap) {
+            y.name  = mipsu_swap(y.name);
+            y.value = mipsu_swap(y.value);
+            y.shndx = mipsu_swap16(y.shndx);
+        }
+
+        if (!y.shndx || (y.info & 0xF) > 2 || !y.name || y.name >= t.size ||
+            !memchr(str + y.name, 0, t.size - y.name))
+            continue;
+
+        e->syms[e->symc].addr  = y.value;
+        e->syms[e->symc].shndx = y.shndx;
+        e->syms[e->symc].name  = str + y.name;
+        ++e->symc;
+    }
+
+    qsort(e->syms, e->symc, sizeof(mipsu_sym_t), mipsu_sym_cmp);
+
+    return MIPSU_RESULT_OK;
+}
+
+/* index of the first symbol at or past a */
+static size_t mipsu_sym_find(const mipsu_elf_t* e, uint32_t a) {
+    size_t lo = 0, hi = e->symc, k;
+
+    while (lo < hi) {
+        k = lo + (hi - lo) / 2;
+
+        if (e->syms[k].addr < a)
+            lo = k + 1;
+        else
+            hi = k;
+    }
+
+    return lo;
+}
+
+static const mipsu_sym_t* mipsu_sym_named(const mipsu_elf_t* e,
+                                          const char* name) {
+    size_t i;
+
+    for (i = 0; i < e->symc; ++i)
+        if (!strcmp(e->syms[i].name, name)) return e->syms + i;
+
+    return NULL;
+}
+
+static void mipsu_elf_close(mipsu_elf_t* e) {
+    free(e->syms);
+    if (e->map.data) mipsu_unmap(e->map);
+}
+
+/* maps the whole file, checking every header table lies inside it */
+static mipsu_result_t mipsu_elf_open(file_t* f, mipsu_elf_t* e) {
+    mipsu_result_t r;
+    size_t         n;
+
+    memset(e, 0, sizeof(mipsu_elf_t));
+
+    if (mipsu_seekable(f)) {
+        r = mipsu_file_size(f, &n);
+    } else {
+        r = mipsu_map_pipe(f, &e->map);
+        n = e->map.size;
+    }
+
+    if (r) return r;
+
+    if (n < sizeof(mipsu_elf_hdr_t) || n > UINT32_MAX)
+        return MIPSU_RESULT_BAD_ELF;
+
+    if (!e->map.data && (r = mipsu_map(f, 0, n, &e->map))) return r;
+
+    memcpy(&e->h, e->map.data, sizeof(mipsu_elf_hdr_t));
+
+    /* the file states its byte order, so --be and --le are not needed */
+    e->swap = e->h.ident[5] == (mipsu_host_be ? mipsu_elf_lsb : mipsu_elf_msb);
+    if (e->swap) mipsu_elf_swap_hdr(&e->h);
+
+    if (memcmp(e->h.ident, mipsu_elf_magic, sizeof(mipsu_elf_magic)) ||
+        e->h.ident[4] != mipsu_elf_class32 ||
+        (e->h.ident[5] != mipsu_elf_lsb && e->h.ident[5] != mipsu_elf_msb) ||
+        e->h.machine != mipsu_elf_mips ||
+        (e->h.shnum && e->h.shentsize < sizeof(mipsu_elf_shdr_t)) ||
+        (e->h.phnum && e->h.phentsize < sizeof(mipsu_elf_phdr_t)) ||
+        !mipsu_elf_at(e, e->h.shoff, (uint32_t)e->h.shnum * e->h.shentsize) ||
+        !mipsu_elf_at(e, e->h.phoff, (uint32_t)e->h.phnum * e->h.phentsize))
+        return MIPSU_RESULT_BAD_ELF;
+
+    return mipsu_elf_syms(e);
+}
+
+/* === Emulation === */
+
+static void mipsu_trap(mipsu_cpu_t* m, mipsu_result_t r) {
+    m->res = r;
+    m->run = false;
+}
+
+static uint32_t mipsu_ea(const mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    return m->r[i->rs] + (uint32_t)i->imm;
+}
+
+static uint8_t* mipsu_arena(mipsu_mem_t* m, size_t n) {
+    uint8_t** v;
+    uint8_t*  p;
+
+    if (m->left < n) {
+        v = realloc(m->chunks, (m->chunkc + 1) * sizeof(uint8_t*));
+        if (!v) return NULL;
+        m->chunks = v;
+
+        if (!(p = calloc(1, mipsu_arena_size))) return NULL;
+
+        m->chunks[m->chunkc++] = p;
+        m->next                = p;
+        m->left                = mipsu_arena_size;
+    }
+
+    p = m->next;
+    m->next += n;
+    m->left -= n;
+
+    return p;
+}
+
+static bool_t mipsu_is_lent(const mipsu_mem_t* m, uint32_t t) {
+    return m->lent && m->lent[t >> 5] >> (t & 31) & 1;
+}
+
+/* a zeroed page for page t, spare if any; noted for restore while lent */
+static uint8_t* mipsu_page_new(mipsu_mem_t* m, uint32_t t) {
+    uint8_t* p = m->spare;
+
+    if (m->lent && !mipsu_grow((void**)&m->dirty, m->dirtyc, &m->dirtycap,
+                               sizeof(uint32_t)))
+        return NULL;
+
+    if (p) {
+        m->spare = *(uint8_t**)p;
+        memset(p, 0, mipsu_page_size);
+    } else if (!(p = mipsu_arena(m, mipsu_page_size)))
+        return NULL;
+
+    if (m->lent) m->dirty[m->dirtyc++] = t;
+
+    return p;
+}
+
+/* the page table entry of page t, whose table must exist */
+static uint8_t** mipsu_page_slot(mipsu_mem_t* m, uint32_t t) {
+    return m->dir[t >> mipsu_table_bits] + (t & ((1 << mipsu_table_bits) - 1));
+}
+
+/* the first store to a lent page copies it, leaving the snapshot's alone */
+static uint8_t* mipsu_page_own(mipsu_mem_t* m, uint32_t t) {
+    uint8_t** e = mipsu_page_slot(m, t);
+    uint8_t*  p = mipsu_page_new(m, t);
+
+    if (!p) return NULL;
+
+    memcpy(p, *e, mipsu_page_size);
+    *e = p;
+
+    m->lent[t >> 5] &= ~(1u << (t & 31));
+    if (m->tag[t & mipsu_tlb_mask] == t) m->page[t & mipsu_tlb_mask] = p;
+
+    return p;
+}
+
+/* the page holding a, allocated on first touch unless p is given to use */
+static uint8_t* mipsu_page(mipsu_mem_t* m, uint32_t a, uint8_t* p) {
+    uint8_t*** d = m->dir + (a >> (mipsu_page_bits + mipsu_table_bits));
+    uint8_t**  t;
+
+    if (!*d) {
+        *d = (uint8_t**)mipsu_arena(m, sizeof(uint8_t*) << mipsu_table_bits);
+        if (!*d) return NULL;
+    }
+
+    t = *d + ((a >> mipsu_page_bits) & ((1 << mipsu_table_bits) - 1));
+
+    if (p)
+        *t = p;
+    else if (!*t)
+        *t = mipsu_page_new(m, a >> mipsu_page_bits);
+
+    return *t;
+}
+
+/* stops the run after the access, if a falls in a watched word */
+static void mipsu_watch_hit(mipsu_cpu_t* m, uint32_t a) {
+    uint32_t i;
+
+    for (i = 0; i < m->watchc; ++i) {
+        if (m->watchv[i] != (a & ~(uint32_t)3)) continue;
+
+        m->hit     = a;
+        m->watched = true;
+        m->run     = false;
+        return;
+    }
+}
+
+/* below text stays unmapped, to trap on null pointers */
+static uint8_t* mipsu_mem_miss(mipsu_cpu_t* m, uint32_t a) {
+    uint32_t t = a >> mipsu_page_bits;
+    uint8_t* p;
+
+    if (a < mipsu_text_base) return NULL;
+
+    p = mipsu_page(&m->mem, a, NULL);
+    if (!p) return NULL;
+
+    if (m->mem.watch && m->mem.watch[t >> 5] >> (t & 31) & 1) {
+        mipsu_watch_hit(m, a);
+        return p + (a & (mipsu_page_size - 1));
+    }
+
+    m->mem.tag[t & mipsu_tlb_mask]  = t;
+    m->mem.page[t & mipsu_tlb_mask] = p;
+
+    return p + (a & (mipsu_page_size - 1));
+}
+
+/* NULL for unaligned or unmapped addresses */
+static uint8_t* mipsu_mem(mipsu_cpu_t* m, uint32_t a, uint32_t n) {
+    uint32_t t = a >> mipsu_page_bits;
+
+    if (a & (n - 1)) return NULL;
+
+    if (t == m->mem.tag[t & mipsu_tlb_mask])
+        return m->mem.page[t & mipsu_tlb_mask] + (a & (mipsu_page_size - 1));
+
+    return mipsu_mem_miss(m, a);
+}
+
+/* widens the range of text stored to, if a is in text */
+static bool_t mipsu_text_note(mipsu_cpu_t* m, uint32_t a) {
+    uint32_t o = a - mipsu_text_base;
+
+    if (o >= m->text) return false;
+
+    if (!m->dirty || o < m->dlo) m->dlo = o;
+    if (!m->dirty || o > m->dhi) m->dhi = o;
+    m->dirty = true;
+
+    return true;
+}
+
+/* notes stores to text for mipsu_text_sync, caching other pages */
+static uint8_t* mipsu_mem_wmiss(mipsu_cpu_t* m, uint32_t a) {
+    uint32_t t = a >> mipsu_page_bits;
+    uint32_t o = a - mipsu_text_base;
+    uint8_t* p;
+
+    if (mipsu_is_lent(&m->mem, t) && !mipsu_page_own(&m->mem, t)) return NULL;
+
+    p = mipsu_mem_miss(m, a);
+    if (!p) return NULL;
+
+    /* the page after text ends may still hold text */
+    if (!mipsu_text_note(m, a) &&
+        (o >> mipsu_page_bits) > ((m->text - 1) >> mipsu_page_bits) &&
+        m->mem.tag[t & mipsu_tlb_mask] == t) {
+        m->mem.wtag[t & mipsu_tlb_mask]  = t;
+        m->mem.wpage[t & mipsu_tlb_mask] = m->mem.page[t & mipsu_tlb_mask];
+    }
+
+    return p;
+}
+
+/* like mipsu_mem, for stores */
+static uint8_t* mipsu_mem_w(mipsu_cpu_t* m, uint32_t a, uint32_t n) {
+    uint32_t t = a >> mipsu_page_bits;
+
+    if (a & (n - 1)) return NULL;
+
+    if (t == m->mem.wtag[t & mipsu_tlb_mask])
+        return m->mem.wpage[t & mipsu_tlb_mask] + (a & (mipsu_page_size - 1));
+
+    return mipsu_mem_wmiss(m, a);
+}
+
+/* the part of [a, a + n) in a's page, cutting n; NULL if unmapped */
+static uint8_t* mipsu_span(mipsu_cpu_t* m, uint32_t a, uint32_t* n, bool_t w) {
+    uint32_t k = mipsu_page_size - (a & (mipsu_page_size - 1));
+    uint8_t* p = w ? mipsu_mem_w(m, a, 1) : mipsu_mem(m, a, 1);
+
+    if (*n > k) *n = k;
+    if (p && w && *n) mipsu_text_note(m, a + *n - 1);
+
+    return p;
+}
+
+/* guest stdout shares the output buffer, flushed only when full */
+static void mipsu_sys_out(mipsu_cpu_t* m, const void* s, size_t n) {
+    mipsu_buff_t* b = m->c.b;
+
+    if (b->cap - b->n < n) mipsu_flush(m->c);
+
+    /* too big to buffer, or a serve reply, which never flushes */
+    if (b->cap - b->n < n) {
+        if (m->c.o) {
+            fwrite(s, 1, n, m->c.o);
+            return;
+        }
+
+        n = b->cap - b->n;
+    }
+
+    memcpy(b->data + b->n, s, n);
+    b->n += n;
+}
+
+/* guest fds 0 to 2 are the host's own */
+static int mipsu_sys_fd(const mipsu_cpu_t* m, uint32_t f) {
+    if (f < 3) return (int)f;
+    if (f - 3 >= mipsu_files) return -1;
+
+    return m->files[f - 3] - 1;
+}
+
+static void mipsu_sys_print_int(mipsu_cpu_t* m) {
+    char t[12];
+
+    mipsu_sys_out(m, t, mipsu_put_dec(t, m->r[mipsu_reg_a0], 0) - t);
+}
+
+static void mipsu_sys_print_str(mipsu_cpu_t* m) {
+    uint32_t       a = m->r[mipsu_reg_a0], n;
+    const uint8_t* p;
+    const uint8_t* z;
+
+    for (;; a += n) {
+        n = mipsu_page_size;
+        p = mipsu_span(m, a, &n, false);
+
+        if (!p) {
+            mipsu_trap(m, MIPSU_RESULT_EMU_ADDR);
+            return;
+        }
+
+        z = memchr(p, 0, n);
+        mipsu_sys_out(m, p, z ? (size_t)(z - p) : n);
+
+        if (z) return;
+    }
+}
+
+static void mipsu_sys_print_chr(mipsu_cpu_t* m) {
+    char ch = (char)m->r[mipsu_reg_a0];
+
+    mipsu_sys_out(m, &ch, 1);
+}
+
+/* reads flush first, so that prompts show */
+static void mipsu_sys_read_int(mipsu_cpu_t* m) {
+    char l[64];
+
+    mipsu_flush(m->c);
+
+    m->r[mipsu_reg_v0] = fgets(l, sizeof(l), m->in) ? strtol(l, NULL, 10) : 0;
+}
+
+/* like fgets, reading at most a1 - 1 bytes */
+static void mipsu_sys_read_str(mipsu_cpu_t* m) {
+    uint32_t a = m->r[mipsu_reg_a0], n = m->r[mipsu_reg_a1], k;
+    uint8_t* p;
+    int      ch = 0;
+
+    if (!n) return;
+
+    mipsu_flush(m->c);
+
+    for (k = 0; k + 1 < n && ch != '\n' && (ch = getc(m->in)) != EOF; ++k) {
+        if (!(p = mipsu_mem_w(m, a + k, 1))) break;
+        *p = (uint8_t)ch;
+    }
+
+    if (!(p = mipsu_mem_w(m, a + k, 1))) {
+        mipsu_trap(m, MIPSU_RESULT_EMU_ADDR);
+        return;
+    }
+
+    *p = 0;
+}
+
+/* the heap only moves a pointer, pages are allocated on first touch */
+static void mipsu_sys_sbrk(mipsu_cpu_t* m) {
+    uint32_t n = (m->r[mipsu_reg_a0] + 7) & ~(uint32_t)7;
+
+    if ((int32_t)m->r[mipsu_reg_a0] < 0 || n > mipsu_heap_max - m->brk) {
+        mipsu_trap(m, MIPSU_RESULT_EMU_ADDR);
+        return;
+    }
+
+    m->r[mipsu_reg_v0] = m->brk;
+    m->brk += n;
+}
+
+static void mipsu_sys_exit(mipsu_cpu_t* m) { m->run = false; }
+
+static void mipsu_sys_read_chr(mipsu_cpu_t* m) {
+    mipsu_flush(m->c);
+
+    m->r[mipsu_reg_v0] = getc(m->in);
+}
+
+/* flags as in MARS: 0 read, 1 write, 9 append; v0 is -1 on failure, and
+ * always without --host-fs, so a guest only reaches the files it is given */
+static void mipsu_sys_open(mipsu_cpu_t* m) {
+    char           path[1 << 10];
+    uint32_t       a = m->r[mipsu_reg_a0], i;
+    const uint8_t* p;
+    int            f, fd;
+
+    for (i = 0; i < sizeof(path); ++i) {
+        if (!(p = mipsu_mem(m, a + i, 1))) {
+            mipsu_trap(m, MIPSU_RESULT_EMU_ADDR);
+            return;
+        }
+
+        if (!(path[i] = (char)*p)) break;
+    }
+
+    m->r[mipsu_reg_v0] = -1;
+
+    if (!mipsu_get_flag(m->c, MIPSU_FLAG_HOST_FS)) return;
+
+    switch (m->r[mipsu_reg_a1]) {
+    case 0:
+        f = O_RDONLY;
+        break;
+    case 1:
+        f = O_WRONLY | O_CREAT | O_TRUNC;
+        break;
+    case 9:
+        f = O_WRONLY | O_CREAT | O_APPEND;
+        break;
+    default:
+        return;
+    }
+
+    for (i = 0; i < mipsu_files && m->files[i]; ++i)
+        ;
+
+    if (i == mipsu_files || !memchr(path, 0, sizeof(path))) return;
+
+    fd = open(path, f, 0666);
+    if (fd < 0) return;
+
+    m->files[i]        = fd + 1;
+    m->r[mipsu_reg_v0] = i + 3;
+}
+
+/* straight into guest memory, a page at a time */
+static void mipsu_sys_read(mipsu_cpu_t* m) {
+    uint32_t a = m->r[mipsu_reg_a1], n = m->r[mipsu_reg_a2], k, t = 0;
+    int      fd = mipsu_sys_fd(m, m->r[mipsu_reg_a0]);
+    uint8_t* p;
+    long     g;
+
+    if (fd < 0 || fd == 1 || fd == 2) {
+        m->r[mipsu_reg_v0] = -1;
+        return;
+    }
+
+    if (!fd) mipsu_flush(m->c);
+
+    for (; t < n; t += g) {
+        k = n - t;
+        p = mipsu_span(m, a + t, &k, true);
+
+        if (!p) {
+            mipsu_trap(m, MIPSU_RESULT_EMU_ADDR);
+            return;
+        }
+
+        g = fd ? (long)read(fd, p, k) : (long)fread(p, 1, k, m->in);
+
+        if (g < 0) {
+            m->r[mipsu_reg_v0] = t ? t : (uint32_t)-1;
+            return;
+        }
+
+        if ((uint32_t)g < k) {
+            t += g;
+            break;
+        }
+    }
+
+    m->r[mipsu_reg_v0] = t;
+}
+
+static void mipsu_sys_write(mipsu_cpu_t* m) {
+    uint32_t       a = m->r[mipsu_reg_a1], n = m->r[mipsu_reg_a2], k, t = 0;
+    int            fd = mipsu_sys_fd(m, m->r[mipsu_reg_a0]);
+    const uint8_t* p;
+    long           g;
+
+    if (fd <= 0) {
+        m->r[mipsu_reg_v0] = -1;
+        return;
+    }
+
+    if (fd == 2) mipsu_flush(m->c);
+
+    for (; t < n; t += g) {
+        k = n - t;
+        p = mipsu_span(m, a + t, &k, false);
+
+        if (!p) {
+            mipsu_trap(m, MIPSU_RESULT_EMU_ADDR);
+            return;
+        }
+
+        if (fd == 1) {
+            mipsu_sys_out(m, p, k);
+            g = k;
+        } else if (fd == 2)
+            g = (long)fwrite(p, 1, k, stderr);
+        else
+            g = (long)write(fd, p, k);
+
+        if (g < 0) {
+            m->r[mipsu_reg_v0] = t ? t : (uint32_t)-1;
+            return;
+        }
+
+        if ((uint32_t)g < k) {
+            t += g;
+            break;
+        }
+    }
+
+    m->r[mipsu_reg_v0] = t;
+}
+
+/* only files the guest opened */
+static void mipsu_sys_close(mipsu_cpu_t* m) {
+    uint32_t f = m->r[mipsu_reg_a0] - 3;
+
+    if (f >= mipsu_files || !m->files[f]) return;
+
+    close(m->files[f] - 1);
+    m->files[f] = 0;
+}
+
+static void mipsu_sys_exit2(mipsu_cpu_t* m) {
+    m->code = m->r[mipsu_reg_a0];
+    m->run  = false;
+}
+
+/* SPIM services, by $v0 */
+static const mipsu_sys_t mipsu_sys_lut[] = {
+    [1]  = mipsu_sys_print_int,
+    [4]  = mipsu_sys_print_str,
+    [5]  = mipsu_sys_read_int,
+    [8]  = mipsu_sys_read_str,
+    [9]  = mipsu_sys_sbrk,
+    [10] = mipsu_sys_exit,
+    [11] = mipsu_sys_print_chr,
+    [12] = mipsu_sys_read_chr,
+    [13] = mipsu_sys_open,
+    [14] = mipsu_sys_read,
+    [15] = mipsu_sys_write,
+    [16] = mipsu_sys_close,
+    [17] = mipsu_sys_exit2,
+};
+static const uint32_t mipsu_sysc =
+    sizeof(mipsu_sys_lut) / sizeof(mipsu_sys_t);
+
+static void mipsu_x_reserved(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    (void)i;
+    mipsu_trap(m, MIPSU_RESULT_EMU_INSTR);
+}
+
+static void mipsu_x_sll(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rd] = m->r[i->rt] << i->imm;
+}
+static void mipsu_x_srl(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rd] = m->r[i->rt] >> i->imm;
+}
+static void mipsu_x_sra(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rd] = (int32_t)m->r[i->rt] >> i->imm;
+}
+static void mipsu_x_sllv(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rd] = m->r[i->rt] << (m->r[i->rs] & 31);
+}
+static void mipsu_x_srlv(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rd] = m->r[i->rt] >> (m->r[i->rs] & 31);
+}
+static void mipsu_x_srav(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rd] = (int32_t)m->r[i->rt] >> (m->r[i->rs] & 31);
+}
+
+/* pc already points at the delay slot, npc is what follows it */
+static void mipsu_x_jr(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->npc = m->r[i->rs];
+}
+static void mipsu_x_jalr(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    uint32_t t = m->r[i->rs];
+
+    m->r[i->rd] = m->npc;
+    m->npc      = t;
+}
+
+static void mipsu_x_syscall(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    uint32_t v = m->r[mipsu_reg_v0];
+    (void)i;
+
+    if (v < mipsu_sysc && mipsu_sys_lut[v])
+        mipsu_sys_lut[v](m);
+    else
+        mipsu_trap(m, MIPSU_RESULT_EMU_SYSCALL);
+}
+static void mipsu_x_break(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    (void)i;
+    mipsu_trap(m, MIPSU_RESULT_EMU_BREAK);
+}
+
+static void mipsu_x_mfhi(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rd] = m->hi;
+}
+static void mipsu_x_mthi(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->hi = m->r[i->rs];
+}
+static void mipsu_x_mflo(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rd] = m->lo;
+}
+static void mipsu_x_mtlo(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->lo = m->r[i->rs];
+}
+
+static void mipsu_x_mult(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    int64_t p = (int64_t)(int32_t)m->r[i->rs] * (int32_t)m->r[i->rt];
+
+    m->lo = (uint32_t)p;
+    m->hi = (uint32_t)((uint64_t)p >> 32);
+}
+static void mipsu_x_multu(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    uint64_t p = (uint64_t)m->r[i->rs] * m->r[i->rt];
+
+    m->lo = (uint32_t)p;
+    m->hi = (uint32_t)(p >> 32);
+}
+
+/* a zero divisor leaves hi and lo unpredictable, here untouched */
+static void mipsu_x_div(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    int32_t s = m->r[i->rs], t = m->r[i->rt];
+
+    if (!t) return;
+
+    if (t == -1 && s == INT32_MIN) {
+        m->lo = s;
+        m->hi = 0;
+        return;
+    }
+
+    m->lo = s / t;
+    m->hi = s % t;
+}
+static void mipsu_x_divu(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    uint32_t s = m->r[i->rs], t = m->r[i->rt];
+
+    if (!t) return;
+
+    m->lo = s / t;
+    m->hi = s % t;
+}
+
+/* signed overflow traps and leaves the destination as it was */
+static void mipsu_x_add(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    uint32_t s = m->r[i->rs], t = m->r[i->rt], d = s + t;
+
+    if (~(s ^ t) & (s ^ d) & 0x80000000)
+        mipsu_trap(m, MIPSU_RESULT_EMU_OVERFLOW);
+    else
+        m->r[i->rd] = d;
+}
+static void mipsu_x_addu(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rd] = m->r[i->rs] + m->r[i->rt];
+}
+static void mipsu_x_sub(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    uint32_t s = m->r[i->rs], t = m->r[i->rt], d = s - t;
+
+    if ((s ^ t) & (s ^ d) & 0x80000000)
+        mipsu_trap(m, MIPSU_RESULT_EMU_OVERFLOW);
+    else
+        m->r[i->rd] = d;
+}
+static void mipsu_x_subu(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rd] = m->r[i->rs] - m->r[i->rt];
+}
+static void mipsu_x_and(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rd] = m->r[i->rs] & m->r[i->rt];
+}
+static void mipsu_x_or(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rd] = m->r[i->rs] | m->r[i->rt];
+}
+static void mipsu_x_xor(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rd] = m->r[i->rs] ^ m->r[i->rt];
+}
+static void mipsu_x_nor(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rd] = ~(m->r[i->rs] | m->r[i->rt]);
+}
+static void mipsu_x_slt(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rd] = (int32_t)m->r[i->rs] < (int32_t)m->r[i->rt];
+}
+static void mipsu_x_sltu(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rd] = m->r[i->rs] < m->r[i->rt];
+}
+
+/* jump targets keep the top bits of the delay slot address */
+static void mipsu_x_j(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->npc = (m->pc & 0xF0000000) | i->imm;
+}
+static void mipsu_x_jal(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[mipsu_reg_ra] = m->npc;
+    m->npc             = (m->pc & 0xF0000000) | i->imm;
+}
+
+/* branch offsets are relative to the delay slot */
+static uint32_t mipsu_br(const mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    return m->pc + ((uint32_t)i->imm << 2);
+}
+
+static void mipsu_x_beq(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    if (m->r[i->rs] == m->r[i->rt]) m->npc = mipsu_br(m, i);
+}
+static void mipsu_x_bne(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    if (m->r[i->rs] != m->r[i->rt]) m->npc = mipsu_br(m, i);
+}
+static void mipsu_x_blez(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    if ((int32_t)m->r[i->rs] <= 0) m->npc = mipsu_br(m, i);
+}
+static void mipsu_x_bgtz(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    if ((int32_t)m->r[i->rs] > 0) m->npc = mipsu_br(m, i);
+}
+
+static void mipsu_x_addi(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    uint32_t s = m->r[i->rs], t = i->imm, d = s + t;
+
+    if (~(s ^ t) & (s ^ d) & 0x80000000)
+        mipsu_trap(m, MIPSU_RESULT_EMU_OVERFLOW);
+    else
+        m->r[i->rt] = d;
+}
+static void mipsu_x_addiu(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rt] = m->r[i->rs] + i->imm;
+}
+static void mipsu_x_andi(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rt] = m->r[i->rs] & (uint16_t)i->imm;
+}
+static void mipsu_x_ori(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rt] = m->r[i->rs] | (uint16_t)i->imm;
+}
+static void mipsu_x_lui(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    m->r[i->rt] = (uint32_t)i->imm << 16;
+}
+
+static void mipsu_x_lb(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    uint8_t* p = mipsu_mem(m, mipsu_ea(m, i), 1);
+
+    if (p)
+        m->r[i->rt] = (int8_t)*p;
+    else
+        mipsu_trap(m, MIPSU_RESULT_EMU_ADDR);
+}
+static void mipsu_x_lh(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    uint8_t* p = mipsu_mem(m, mipsu_ea(m, i), 2);
+    int16_t  v;
+
+    if (!p) {
+        mipsu_trap(m, MIPSU_RESULT_EMU_ADDR);
+        return;
+    }
+
+    memcpy(&v, p, sizeof(v));
+    m->r[i->rt] = v;
+}
+static void mipsu_x_lw(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    uint8_t* p = mipsu_mem(m, mipsu_ea(m, i), 4);
+
+    if (p)
+        memcpy(&m->r[i->rt], p, 4);
+    else
+        mipsu_trap(m, MIPSU_RESULT_EMU_ADDR);
+}
+static void mipsu_x_lbu(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    uint8_t* p = mipsu_mem(m, mipsu_ea(m, i), 1);
+
+    if (p)
+        m->r[i->rt] = *p;
+    else
+        mipsu_trap(m, MIPSU_RESULT_EMU_ADDR);
+}
+static void mipsu_x_lhu(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    uint8_t* p = mipsu_mem(m, mipsu_ea(m, i), 2);
+    uint16_t v;
+
+    if (!p) {
+        mipsu_trap(m, MIPSU_RESULT_EMU_ADDR);
+        return;
+    }
+
+    memcpy(&v, p, sizeof(v));
+    m->r[i->rt] = v;
+}
+static void mipsu_x_sb(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    uint8_t* p = mipsu_mem_w(m, mipsu_ea(m, i), 1);
+
+    if (p)
+        *p = m->r[i->rt];
+    else
+        mipsu_trap(m, MIPSU_RESULT_EMU_ADDR);
+}
+static void mipsu_x_sh(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    uint8_t* p = mipsu_mem_w(m, mipsu_ea(m, i), 2);
+    uint16_t v = m->r[i->rt];
+
+    if (p)
+        memcpy(p, &v, sizeof(v));
+    else
+        mipsu_trap(m, MIPSU_RESULT_EMU_ADDR);
+}
+static void mipsu_x_sw(mipsu_cpu_t* m, const mipsu_pre_t* i) {
+    uint8_t* p = mipsu_mem_w(m, mipsu_ea(m, i), 4);
+
+    if (p)
+        memcpy(p, &m->r[i->rt], 4);
+    else
+        mipsu_trap(m, MIPSU_RESULT_EMU_ADDR);
+}
+
+/* indexed like mipsu_instr_lut; op 0 goes through fn, its slot is spare */
+static const mipsu_exec_t mipsu_exec_lut[128] = {
+    [MIPSU_FN(0x00)] = mipsu_x_sll,
+    [MIPSU_FN(0x02)] = mipsu_x_srl,
+    [MIPSU_FN(0x03)] = mipsu_x_sra,
+    [MIPSU_FN(0x04)] = mipsu_x_sllv,
+    [MIPSU_FN(0x06)] = mipsu_x_srlv,
+    [MIPSU_FN(0x07)] = mipsu_x_srav,
+
+    [MIPSU_FN(0x08)] = mipsu_x_jr,
+    [MIPSU_FN(0x09)] = mipsu_x_jalr,
+    [MIPSU_FN(0x0C)] = mipsu_x_syscall,
+    [MIPSU_FN(0x0D)] = mipsu_x_break,
+
+    [MIPSU_FN(0x10)] = mipsu_x_mfhi,
+    [MIPSU_FN(0x11)] = mipsu_x_mthi,
+    [MIPSU_FN(0x12)] = mipsu_x_mflo,
+    [MIPSU_FN(0x13)] = mipsu_x_mtlo,
+    [MIPSU_FN(0x18)] = mipsu_x_mult,
+    [MIPSU_FN(0x19)] = mipsu_x_multu,
+    [MIPSU_FN(0x1A)] = mipsu_x_div,
+    [MIPSU_FN(0x1B)] = mipsu_x_divu,
+
+    [MIPSU_FN(0x20)] = mipsu_x_add,
+    [MIPSU_FN(0x21)] = mipsu_x_addu,
+    [MIPSU_FN(0x22)] = mipsu_x_sub,
+    [MIPSU_FN(0x23)] = mipsu_x_subu,
+    [MIPSU_FN(0x24)] = mipsu_x_and,
+    [MIPSU_FN(0x25)] = mipsu_x_or,
+    [MIPSU_FN(0x26)] = mipsu_x_xor,
+    [MIPSU_FN(0x27)] = mipsu_x_nor,
+    [MIPSU_FN(0x2A)] = mipsu_x_slt,
+    [MIPSU_FN(0x2B)] = mipsu_x_sltu,
+
+    [MIPSU_OP(0x00)] = mipsu_x_reserved,
+
+    [MIPSU_OP(0x02)] = mipsu_x_j,
+    [MIPSU_OP(0x03)] = mipsu_x_jal,
+    [MIPSU_OP(0x04)] = mipsu_x_beq,
+    [MIPSU_OP(0x05)] = mipsu_x_bne,
+    [MIPSU_OP(0x06)] = mipsu_x_blez,
+    [MIPSU_OP(0x07)] = mipsu_x_bgtz,
+
+    [MIPSU_OP(0x08)] = mipsu_x_addi,
+    [MIPSU_OP(0x09)] = mipsu_x_addiu,
+    [MIPSU_OP(0x0C)] = mipsu_x_andi,
+    [MIPSU_OP(0x0D)] = mipsu_x_ori,
+    [MIPSU_OP(0x0F)] = mipsu_x_lui,
+
+    [MIPSU_OP(0x20)] = mipsu_x_lb,
+    [MIPSU_OP(0x21)] = mipsu_x_lh,
+    [MIPSU_OP(0x23)] = mipsu_x_lw,
+    [MIPSU_OP(0x24)] = mipsu_x_lbu,
+    [MIPSU_OP(0x25)] = mipsu_x_lhu,
+    [MIPSU_OP(0x28)] = mipsu_x_sb,
+    [MIPSU_OP(0x29)] = mipsu_x_sh,
+    [MIPSU_OP(0x2B)] = mipsu_x_sw,
+};
+
+/* with s, as under --strict, words that are not canonical are reserved */
+static mipsu_pre_t mipsu_predecode(mipsu_word_t w, bool_t s) {
+    mipsu_field_t f = mipsu_decode(w);
+    mipsu_pre_t   p = {};
+    size_t        k = mipsu_instr_idx(w);
+
+    p.h = mipsu_exec_lut[k] && !(s && f.res) ? k : MIPSU_OP(0x00);
+
+    switch (f.type) {
+    case MIPSU_TYPE_R:
+        p.rs  = f.rs;
+        p.rt  = f.rt;
+        p.rd  = f.rd;
+        p.imm = f.sh;
+        break;
+    case MIPSU_TYPE_I:
+        p.rs  = f.rs;
+        p.rt  = f.rt;
+        p.imm = f.imm;
+        break;
+    case MIPSU_TYPE_J:
+        p.imm = f.addr << 2;
+        break;
+    }
+
+    return p;
+}
+
+static void mipsu_emu_free(mipsu_cpu_t* m) {
+    size_t i;
+
+    for (i = 0; i < mipsu_files; ++i)
+        if (m->files[i]) close(m->files[i] - 1);
+
+    for (i = 0; i < m->mem.chunkc; ++i)
+        free(m->mem.chunks[i]);
+    free(m->mem.chunks);
+    free(m->mem.watch);
+    free(m->mem.lent);
+    free(m->mem.dirty);
+    free(m->snap.t);
+    free(m->snap.p);
+    free(m->blocks);
+    free(m->pre);
+    free(m->bp);
+}
+
+/*
+ * Loads n words of text. With z set, w is page aligned and outlives the
+ * run, so its pages are mapped in place instead of being copied. pre, when
+ * given, is w already decoded, and is copied instead of decoding again.
+ */
+static mipsu_result_t mipsu_emu_init(mipsu_cpu_t* m, const mipsu_word_t* w,
+                                     size_t n, bool_t z,
+                                     const mipsu_pre_t* pre, mipsu_cli_t c) {
+    const uint8_t* b = (const uint8_t*)w;
+    uint8_t*       p;
+    size_t         i, k;
+    bool_t         s;
+
+    memset(m, 0, sizeof(mipsu_cpu_t));
+
+    m->c   = c;
+    m->in  = stdin;
+    m->brk = mipsu_heap_base;
+
+    memset(m->mem.tag, 0xFF, sizeof(m->mem.tag));
+    memset(m->mem.wtag, 0xFF, sizeof(m->mem.wtag));
+
+    if (n > (mipsu_data_base - mipsu_text_base) / mipsu_word_size)
+        return MIPSU_RESULT_BUFF_OVERFLOW;
+
+    m->text = n * mipsu_word_size;
+
+    for (i = 0; i < m->text; i += mipsu_page_size) {
+        k = m->text - i < mipsu_page_size ? m->text - i : mipsu_page_size;
+        p = z ? (uint8_t*)b + i : NULL;
+        p = mipsu_page(&m->mem, mipsu_text_base + i, p);
+
+        if (!p) return MIPSU_RESULT_BUFF_OVERFLOW;
+        if (!z) memcpy(p, b + i, k);
+    }
+
+    /* one spare entry, so that an empty text still allocates */
+    m->pre    = malloc((n + 1) * sizeof(mipsu_pre_t));
+    m->blocks = calloc(n + 1, sizeof(mipsu_block_t*));
+
+    if (!m->pre || !m->blocks) return MIPSU_RESULT_BUFF_OVERFLOW;
+
+    s = mipsu_get_flag(c, MIPSU_FLAG_STRICT);
+
+    if (pre)
+        memcpy(m->pre, pre, n * sizeof(mipsu_pre_t));
+    else
+        for (i = 0; i < n; ++i)
+            m->pre[i] = mipsu_predecode(w[i], s);
+
+    m->r[mipsu_reg_gp] = mipsu_gp_init;
+    m->r[mipsu_reg_sp] = mipsu_sp_init;
+    m->pc              = mipsu_text_base;
+    m->npc             = mipsu_text_base + mipsu_word_size;
+    m->run             = true;
+
+    return MIPSU_RESULT_OK;
+}
+
+static bool_t mipsu_is_branch(uint8_t h) {
+    switch (h) {
+    case MIPSU_FN(0x08):
+    case MIPSU_FN(0x09):
+    case MIPSU_OP(0x02):
+    case MIPSU_OP(0x03):
+    case MIPSU_OP(0x04):
+    case MIPSU_OP(0x05):
+    case MIPSU_OP(0x06):
+    case MIPSU_OP(0x07):
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool_t mipsu_bp_at(const mipsu_cpu_t* m, uint32_t k) {
+    return m->bp && m->bp[k >> 6] >> (k & 63) & 1;
+}
+
+/* blocks end before breakpoints, so only block entry needs a check */
+static mipsu_block_t* mipsu_block_new(mipsu_cpu_t* m, uint32_t k) {
+    mipsu_block_t* b;
+    uint32_t       e, n = m->text / mipsu_word_size;
+
+    b = (mipsu_block_t*)mipsu_arena(&m->mem, sizeof(mipsu_block_t));
+    if (!b) return NULL;
+
+    for (e = k; e < n && e - k < mipsu_block_max; ++e) {
+        if (e > k && mipsu_bp_at(m, e)) break;
+        if (!mipsu_is_branch(m->pre[e].h)) continue;
+
+        b->tail = e + 1 < n ? 2 : 1;
+        e += b->tail;
+        break;
+    }
+
+    b->pc   = mipsu_text_base + k * mipsu_word_size;
+    b->n    = e - k;
+    b->i    = m->pre + k;
+    b->next = m->all;
+    m->all  = b;
+
+    return m->blocks[k] = b;
+}
+
+/*
+ * NULL once the run is over: off the end of text, off text, no memory, or
+ * at a breakpoint. Linked blocks skip this, so blocks at breakpoints are
+ * dropped when these are set.
+ */
+static mipsu_block_t* mipsu_block_at(mipsu_cpu_t* m, uint32_t pc) {
+    uint32_t o = pc - mipsu_text_base;
+
+    if (o >= m->text || o & 3) {
+        if (o != m->text) mipsu_trap(m, MIPSU_RESULT_EMU_PC);
+        m->run = false;
+        return NULL;
+    }
+
+    if (mipsu_bp_at(m, o >> 2)) {
+        m->broke = true;
+        m->run   = false;
+        return NULL;
+    }
+
+    if (m->blocks[o >> 2]) return m->blocks[o >> 2];
+
+    if (mipsu_block_new(m, o >> 2)) return m->blocks[o >> 2];
+
+    mipsu_trap(m, MIPSU_RESULT_BUFF_OVERFLOW);
+    return NULL;
+}
+
+/* drops every block overlapping text words [lo, hi] */
+static void mipsu_block_drop(mipsu_cpu_t* m, uint32_t lo, uint32_t hi) {
+    mipsu_block_t* b;
+    uint32_t       k;
+
+    /* a block holds at most mipsu_block_max words and a delay slot */
+    k = lo > mipsu_block_max ? lo - mipsu_block_max : 0;
+
+    for (; k <= hi; ++k) {
+        b = m->blocks[k];
+
+        if (b && k + b->n > lo) {
+            b->pc        = 1;
+            m->blocks[k] = NULL;
+        }
+    }
+}
+
+/* re-decodes stored text and drops every block overlapping it */
+static void mipsu_text_sync(mipsu_cpu_t* m) {
+    uint32_t     lo = m->dlo >> 2, hi = m->dhi >> 2, k;
+    bool_t       s  = mipsu_get_flag(m->c, MIPSU_FLAG_STRICT);
+    mipsu_word_t w;
+
+    for (k = lo; k <= hi; ++k) {
+        memcpy(&w, mipsu_mem(m, mipsu_text_base + (k << 2), 4), 4);
+        m->pre[k] = mipsu_predecode(w, s);
+    }
+
+    mipsu_block_drop(m, lo, hi);
+
+    m->dirty = false;
+}
+
+/*
+ * Only a block's tail reads pc, so the words before it run without pc kept;
+ * it is set to the delay slot before the branch, as the handlers expect.
+ * Running off the end of text is a normal exit.
+ */
+static void mipsu_emu_loop(mipsu_cpu_t* m) {
+    mipsu_block_t*     b = mipsu_block_at(m, m->pc);
+    mipsu_block_t*     l;
+    const mipsu_pre_t* i;
+    uint32_t           k, n, s;
+
+    while (b) {
+        i = b->i;
+        n = b->n;
+        s = n - b->tail;
+
+        for (k = 0; k < n; ++k) {
+            if (k == s) {
+                m->pc  = b->pc + ((k + 1) << 2);
+                m->npc = m->pc + mipsu_word_size;
+            }
+
+            mipsu_exec_lut[i[k].h](m, i + k);
+            m->r[0] = 0;
+
+            if (!m->run) break;
+        }
+
+        if (!m->run) {
+            m->n += k + 1;
+
+            /* pc and npc follow the word that stopped, to resume from */
+            if (k < s) {
+                m->pc  = b->pc + ((k + 1) << 2);
+                m->npc = m->pc + mipsu_word_size;
+            } else if (k > s) {
+                m->pc  = m->npc;
+                m->npc = m->pc + mipsu_word_size;
+            }
+
+            m->cur   = b->pc + (k << 2);
+            m->last  = b;
+            m->lastn = k + 1;
+            break;
+        }
+
+        m->cur = b->pc + ((n - 1) << 2);
+        m->n += n;
+        ++b->hits;
+
+        if (!b->tail)
+            m->pc = b->pc + (n << 2);
+        else if (b->tail == 2)
+            m->pc = m->npc;
+
+        m->npc = m->pc + mipsu_word_size;
+
+        k = m->pc == b->pc + (n << 2);
+        l = b->link[k];
+
+        b->taken += !k;
+
+        if (m->dirty) mipsu_text_sync(m);
+
+        if (!l || l->pc != m->pc) l = b->link[k] = mipsu_block_at(m, m->pc);
+
+        b = l;
+    }
+}
+
+/* === Snapshots === */
+
+static const char     mipsu_snap_magic[8] = "mipsusnp";
+static const uint32_t mipsu_snap_version  = 1;
+
+static void mipsu_lend(mipsu_mem_t* m, uint32_t t) {
+    m->lent[t >> 5] |= 1u << (t & 31);
+}
+
+/* the index of page t in s, or s->pn without it */
+static size_t mipsu_snap_find(const mipsu_snap_t* s, uint32_t t) {
+    size_t lo = 0, hi = s->pn, k;
+
+    while (lo < hi) {
+        k = lo + (hi - lo) / 2;
+
+        if (s->t[k] < t)
+            lo = k + 1;
+        else
+            hi = k;
+    }
+
+    return lo < s->pn && s->t[lo] == t ? lo : s->pn;
+}
+
+/* counts mapped pages in order, listing them too when t and p are given */
+static size_t mipsu_snap_walk(const mipsu_mem_t* m, uint32_t* t,
+                              uint8_t** p) {
+    size_t   k = 0;
+    uint32_t i, j;
+
+    for (i = 0; i < sizeof(m->dir) / sizeof(*m->dir); ++i) {
+        for (j = 0; m->dir[i] && j < 1 << mipsu_table_bits; ++j) {
+            if (!m->dir[i][j]) continue;
+
+            if (t) {
+                t[k] = i << mipsu_table_bits | j;
+                p[k] = m->dir[i][j];
+            }
+
+            ++k;
+        }
+    }
+
+    return k;
+}
+
+static void mipsu_snap_free(mipsu_snap_t* s) {
+    free(s->t);
+    free(s->p);
+}
+
+/*
+ * Lends every mapped page to a new snapshot, so no page is copied until
+ * stored to. Pages of an older one that were copied since are spare.
+ */
+static mipsu_result_t mipsu_snap_take(mipsu_cpu_t* m) {
+    mipsu_mem_t*  d = &m->mem;
+    mipsu_snap_t* s = &m->snap;
+    uint32_t*     t;
+    uint8_t**     p;
+    size_t        i, k, n;
+
+    if (m->dirty) mipsu_text_sync(m);
+
+    if (!d->lent) {
+        d->lent = calloc(1 << (32 - mipsu_page_bits - 5), 4);
+        if (!d->lent) return MIPSU_RESULT_BUFF_OVERFLOW;
+    }
+
+    n = mipsu_snap_walk(d, NULL, NULL);
+    t = malloc((n + 1) * sizeof(uint32_t));
+    p = malloc((n + 1) * sizeof(uint8_t*));
+
+    if (!t || !p) {
+        free(t);
+        free(p);
+        return MIPSU_RESULT_BUFF_OVERFLOW;
+    }
+
+    for (i = 0; i < d->dirtyc; ++i) {
+        k = mipsu_snap_find(s, d->dirty[i]);
+        if (k == s->pn) continue;
+
+        *(uint8_t**)s->p[k] = d->spare;
+        d->spare            = s->p[k];
+    }
+
+    mipsu_snap_free(s);
+
+    s->t  = t;
+    s->p  = p;
+    s->pn = mipsu_snap_walk(d, t, p);
+
+    for (i = 0; i < s->pn; ++i)
+        mipsu_lend(d, t[i]);
+
+    memcpy(s->r, m->r, sizeof(m->r));
+    s->hi   = m->hi;
+    s->lo   = m->lo;
+    s->pc   = m->pc;
+    s->npc  = m->npc;
+    s->cur  = m->cur;
+    s->brk  = m->brk;
+    s->text = m->text;
+    s->code = m->code;
+    s->n    = m->n;
+
+    d->dirtyc = 0;
+
+    /* stores to lent pages must miss, to copy them */
+    memset(d->wtag, 0xFF, sizeof(d->wtag));
+
+    return MIPSU_RESULT_OK;
+}
+
+static void mipsu_snap_regs(mipsu_cpu_t* m, const mipsu_snap_t* s) {
+    memcpy(m->r, s->r, sizeof(m->r));
+    m->hi   = s->hi;
+    m->lo   = s->lo;
+    m->pc   = s->pc;
+    m->npc  = s->npc;
+    m->cur  = s->cur;
+    m->brk  = s->brk;
+    m->code = s->code;
+    m->n    = s->n;
+    m->run  = true;
+}
+
+/*
+ * Gives pages copied or mapped since the snapshot back to spare, lending
+ * its own again, so restoring costs as much as the pages dirtied. Text
+ * among them is decoded again.
+ */
+static mipsu_result_t mipsu_snap_restore(mipsu_cpu_t* m) {
+    mipsu_mem_t*  d = &m->mem;
+    mipsu_snap_t* s = &m->snap;
+    uint8_t**     e;
+    uint32_t      t, a;
+    size_t        i, k;
+
+    if (!d->lent) return MIPSU_RESULT_NO_SNAP;
+
+    for (i = 0; i < d->dirtyc; ++i) {
+        t = d->dirty[i];
+        e = mipsu_page_slot(d, t);
+        k = mipsu_snap_find(s, t);
+
+        *(uint8_t**)*e = d->spare;
+        d->spare       = *e;
+        *e             = k < s->pn ? s->p[k] : NULL;
+
+        if (k < s->pn) mipsu_lend(d, t);
+
+        a = t << mipsu_page_bits;
+        if (!mipsu_text_note(m, a)) continue;
+
+        a += mipsu_page_size - 1;
+        mipsu_text_note(m, a - mipsu_text_base < m->text
+                               ? a
+                               : mipsu_text_base + m->text - 1);
+    }
+
+    d->dirtyc = 0;
+
+    memset(d->tag, 0xFF, sizeof(d->tag));
+    memset(d->wtag, 0xFF, sizeof(d->wtag));
+
+    if (m->dirty) mipsu_text_sync(m);
+
+    mipsu_snap_regs(m, s);
+    m->res     = MIPSU_RESULT_OK;
+    m->broke   = false;
+    m->watched = false;
+
+    return MIPSU_RESULT_OK;
+}
+
+/*
+ * Saves the snapshot just taken, with m's text decoded as it still is;
+ * pages start page aligned in the file, for loading to map them in place.
+ */
+static mipsu_result_t mipsu_snap_save(const mipsu_cpu_t* m, const char* s) {
+    static const uint8_t z[4096];
+    const mipsu_snap_t*  p = &m->snap;
+    mipsu_snap_hdr_t     h;
+    size_t               i, o, w = p->text / mipsu_word_size;
+    bool_t               ok;
+    file_t*              f;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, mipsu_snap_magic, sizeof(h.magic));
+    memcpy(h.r, p->r, sizeof(h.r));
+    h.version = mipsu_snap_version;
+    h.pages   = p->pn;
+    h.hi      = p->hi;
+    h.lo      = p->lo;
+    h.pc      = p->pc;
+    h.npc     = p->npc;
+    h.cur     = p->cur;
+    h.brk     = p->brk;
+    h.text    = p->text;
+    h.code    = p->code;
+    h.n       = p->n;
+
+    o = sizeof(h) + p->pn * sizeof(uint32_t) + w * sizeof(mipsu_pre_t);
+
+    if (!(f = fopen(s, "wb"))) return MIPSU_RESULT_OPEN_FILE;
+
+    ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+         fwrite(p->t, sizeof(uint32_t), p->pn, f) == p->pn &&
+         fwrite(m->pre, sizeof(mipsu_pre_t), w, f) == w &&
+         fwrite(z, 1, -o & (mipsu_page_size - 1), f) ==
+             (-o & (mipsu_page_size - 1));
+
+    for (i = 0; ok && i < p->pn; ++i)
+        ok = fwrite(p->p[i], mipsu_page_size, 1, f) == 1;
+
+    if (fclose(f) || !ok) return MIPSU_RESULT_OPEN_FILE;
+
+    return MIPSU_RESULT_OK;
+}
+
+/*
+ * Every field that indexes memory or text is checked, so that a resumed
+ * run only traps where it ran; registers, code and n may hold anything.
+ * pc and cur may sit at the end of text, where a run exits, and npc one
+ * word past it.
+ */
+static bool_t mipsu_snap_check(const mipsu_snap_hdr_t* h, size_t n) {
+    const uint32_t*    t = (const uint32_t*)(h + 1);
+    const mipsu_pre_t* pre;
+    size_t             i, o, w = h->text / mipsu_word_size;
+
+    if (n < sizeof(*h)) return false;
+
+    if (memcmp(h->magic, mipsu_snap_magic, sizeof(h->magic)) ||
+        h->version != mipsu_snap_version || h->text % mipsu_word_size ||
+        h->text > mipsu_data_base - mipsu_text_base ||
+        h->pages > 1u << (32 - mipsu_page_bits) || h->brk < mipsu_heap_base ||
+        h->brk > mipsu_heap_max)
+        return false;
+
+    if ((h->pc | h->npc | h->cur) & 3 || h->pc - mipsu_text_base > h->text ||
+        h->cur - mipsu_text_base > h->text ||
+        h->npc - mipsu_text_base > h->text + mipsu_word_size)
+        return false;
+
+    o = sizeof(*h) + h->pages * sizeof(uint32_t) + w * sizeof(mipsu_pre_t);
+    o += -o & (mipsu_page_size - 1);
+
+    if (n != o + (size_t)h->pages * mipsu_page_size) return false;
+
+    pre = (const mipsu_pre_t*)(t + h->pages);
+
+    for (i = 0; i < h->pages; ++i)
+        if (t[i] < mipsu_text_base >> mipsu_page_bits ||
+            t[i] >= 1u << (32 - mipsu_page_bits) || (i && t[i] <= t[i - 1]))
+            return false;
+
+    for (i = 0; i < w; ++i)
+        if (pre[i].h >= 128 || !mipsu_exec_lut[pre[i].h] || pre[i].rs > 31 ||
+            pre[i].rt > 31 || pre[i].rd > 31)
+            return false;
+
+    return true;
+}
+
+/* maps a snapshot file, or reads a pipe whole, to lend its pages from */
+static mipsu_result_t mipsu_snap_load(file_t* f, mipsu_snap_t* s) {
+    const mipsu_snap_hdr_t* h;
+    const uint8_t*          d;
+    size_t                  i, n;
+    mipsu_result_t          r = MIPSU_RESULT_OK;
+
+    memset(s, 0, sizeof(mipsu_snap_t));
+
+    if (!mipsu_seekable(f))
+        r = mipsu_map_pipe(f, &s->map);
+    else if (!(r = mipsu_file_size(f, &n)) && n)
+        r = mipsu_map(f, 0, n, &s->map);
+
+    if (r) return r;
+
+    d = s->map.data;
+    n = s->map.size;
+    h = (const mipsu_snap_hdr_t*)d;
+
+    if (!mipsu_snap_check(h, n)) {
+        if (d) mipsu_unmap(s->map);
+        memset(s, 0, sizeof(mipsu_snap_t));
+        return MIPSU_RESULT_BAD_SNAP;
+    }
+
+    s->pn = h->pages;
+    s->t  = malloc((s->pn + 1) * sizeof(uint32_t));
+    s->p  = malloc((s->pn + 1) * sizeof(uint8_t*));
+
+    if (!s->t || !s->p) {
+        mipsu_unmap(s->map);
+        mipsu_snap_free(s);
+        memset(s, 0, sizeof(mipsu_snap_t));
+        return MIPSU_RESULT_BUFF_OVERFLOW;
+    }
+
+    memcpy(s->t, h + 1, s->pn * sizeof(uint32_t));
+    memcpy(s->r, h->r, sizeof(s->r));
+
+    s->pre  = (const mipsu_pre_t*)((const uint32_t*)(h + 1) + s->pn);
+    s->hi   = h->hi;
+    s->lo   = h->lo;
+    s->pc   = h->pc;
+    s->npc  = h->npc;
+    s->cur  = h->cur;
+    s->brk  = h->brk;
+    s->text = h->text;
+    s->code = h->code;
+    s->n    = h->n;
+
+    d = d + n - s->pn * mipsu_page_size;
+    for (i = 0; i < s->pn; ++i)
+        s->p[i] = (uint8_t*)d + i * mipsu_page_size;
+
+    return MIPSU_RESULT_OK;
+}
+
+/*
+ * Sets m up in the state s holds, its pages lent, so a run of it starts
+ * without loading, decoding or copying. s and its pages outlive the run.
+ */
+static mipsu_result_t mipsu_emu_resume(mipsu_cpu_t* m, const mipsu_snap_t* s,
+                                       mipsu_cli_t c) {
+    mipsu_snap_t* d = &m->snap;
+    size_t        i, n = s->text / mipsu_word_size;
+    uint32_t*     t;
+    uint8_t**     p;
+
+    memset(m, 0, sizeof(mipsu_cpu_t));
+
+    m->c    = c;
+    m->in   = stdin;
+    m->text = s->text;
+
+    memset(m->mem.tag, 0xFF, sizeof(m->mem.tag));
+    memset(m->mem.wtag, 0xFF, sizeof(m->mem.wtag));
+
+    m->pre      = malloc((n + 1) * sizeof(mipsu_pre_t));
+    m->blocks   = calloc(n + 1, sizeof(mipsu_block_t*));
+    m->mem.lent = calloc(1 << (32 - mipsu_page_bits - 5), 4);
+    t           = malloc((s->pn + 1) * sizeof(uint32_t));
+    p           = malloc((s->pn + 1) * sizeof(uint8_t*));
+
+    /* the copy to restore to shares the pages, never owning the map */
+    *d          = *s;
+    d->t        = t;
+    d->p        = p;
+    d->pre      = NULL;
+    d->map.data = NULL;
+
+    if (!m->pre || !m->blocks || !m->mem.lent || !t || !p)
+        return MIPSU_RESULT_BUFF_OVERFLOW;
+
+    memcpy(m->pre, s->pre, n * sizeof(mipsu_pre_t));
+    memcpy(t, s->t, s->pn * sizeof(uint32_t));
+    memcpy(p, s->p, s->pn * sizeof(uint8_t*));
+
+    for (i = 0; i < s->pn; ++i) {
+        if (!mipsu_page(&m->mem, s->t[i] << mipsu_page_bits, s->p[i]))
+            return MIPSU_RESULT_BUFF_OVERFLOW;
+
+        mipsu_lend(&m->mem, s->t[i]);
+    }
+
+    mipsu_snap_regs(m, s);
+
+    return MIPSU_RESULT_OK;
+}
+
+/* === Profiling === */
+
+/*
+ * "MPRF", then LEB128 varints: version, text words, instructions run, a
+ * count per word, nonzero taken counts as (word delta, count) pairs, and
+ * nonzero mnemonic counts as (instr LUT index, count) pairs.
+ */
+static const char    mipsu_prof_magic[4] = "MPRF";
+static const uint8_t mipsu_prof_version  = 1;
+
+static void mipsu_prof_free(mipsu_prof_t* p) {
+    free(p->hits);
+    free(p->taken);
+}
+
+static mipsu_result_t mipsu_prof_alloc(mipsu_prof_t* p, size_t n) {
+    memset(p, 0, sizeof(mipsu_prof_t));
+
+    p->words = n;
+    p->hits  = calloc(n + 1, sizeof(uint64_t));
+    p->taken = calloc(n + 1, sizeof(uint64_t));
+
+    if (p->hits && p->taken) return MIPSU_RESULT_OK;
+
+    mipsu_prof_free(p);
+    return MIPSU_RESULT_BUFF_OVERFLOW;
+}
+
+/* spreads block counts over their words; dropped blocks still count */
+static mipsu_result_t mipsu_prof_build(const mipsu_cpu_t* m, mipsu_prof_t* p) {
+    const mipsu_block_t* b;
+    size_t               j, k;
+    mipsu_result_t       r;
+
+    r = mipsu_prof_alloc(p, m->text / mipsu_word_size);
+    if (r) return r;
+
+    for (b = m->all; b; b = b->next) {
+        k = b->i - m->pre;
+
+        for (j = 0; j < b->n; ++j)
+            p->hits[k + j] += b->hits;
+
+        if (b->tail) p->taken[k + b->n - b->tail] += b->taken;
+    }
+
+    if (m->last)
+        for (j = 0, k = m->last->i - m->pre; j < m->lastn; ++j)
+            ++p->hits[k + j];
+
+    for (k = 0; k < p->words; ++k)
+        p->instr[m->pre[k].h] += p->hits[k];
+
+    p->n = m->n;
+
+    return MIPSU_RESULT_OK;
+}
+
+static uint8_t* mipsu_put_var(uint8_t* p, uint64_t v) {
+    for (; v >= 0x80; v >>= 7)
+        *p++ = (uint8_t)(v | 0x80);
+    *p++ = (uint8_t)v;
+
+    return p;
+}
+
+static bool_t mipsu_get_var(const uint8_t** p, const uint8_t* e,
+                            uint64_t* v) {
+    size_t s;
+
+    for (*v = 0, s = 0; *p < e && s < 64; s += 7) {
+        *v |= (uint64_t)(**p & 0x7F) << s;
+        if (!(*(*p)++ & 0x80)) return true;
+    }
+
+    return false;
+}
+
+static mipsu_result_t mipsu_prof_save(const mipsu_prof_t* p, const char* s) {
+    uint8_t*       d;
+    uint8_t*       q;
+    size_t         i, k, n;
+    file_t*        f;
+    mipsu_result_t r = MIPSU_RESULT_OK;
+
+    /* a varint takes at most 10 bytes, and each count at most three */
+    d = malloc(sizeof(mipsu_prof_magic) + 10 * (3 * p->words + 2 * 128 + 6));
+    if (!d) return MIPSU_RESULT_BUFF_OVERFLOW;
+
+    memcpy(d, mipsu_prof_magic, sizeof(mipsu_prof_magic));
+    q = d + sizeof(mipsu_prof_magic);
+    q = mipsu_put_var(q, mipsu_prof_version);
+    q = mipsu_put_var(q, p->words);
+    q = mipsu_put_var(q, p->n);
+
+    for (i = 0; i < p->words; ++i)
+        q = mipsu_put_var(q, p->hits[i]);
+
+    for (i = n = 0; i < p->words; ++i)
+        n += !!p->taken[i];
+
+    q = mipsu_put_var(q, n);
+    for (i = k = 0; i < p->words; ++i) {
+        if (!p->taken[i]) continue;
+        q = mipsu_put_var(q, i - k);
+        q = mipsu_put_var(q, p->taken[i]);
+        k = i;
+    }
+
+    for (i = n = 0; i < 128; ++i)
+        n += !!p->instr[i];
+
+    q = mipsu_put_var(q, n);
+    for (i = 0; i < 128; ++i) {
+        if (!p->instr[i]) continue;
+        q = mipsu_put_var(q, i);
+        q = mipsu_put_var(q, p->instr[i]);
+    }
+
+    f = fopen(s, "wb");
+
+    if (!f)
+        r = MIPSU_RESULT_OPEN_FILE;
+    else if (fwrite(d, 1, q - d, f) != (size_t)(q - d) || fclose(f))
+        r = MIPSU_RESULT_OPEN_FILE;
+
+    free(d);
+    return r;
+}
+
+static mipsu_result_t mipsu_prof_parse(mipsu_prof_t* p, const uint8_t* d,
+                                       size_t n) {
+    const uint8_t* e = d + n;
+    uint64_t       v, w, k, i, c;
+    mipsu_result_t r;
+
+    if (n < sizeof(mipsu_prof_magic) ||
+        memcmp(d, mipsu_prof_magic, sizeof(mipsu_prof_magic)))
+        return MIPSU_RESULT_BAD_PROF;
+
+    d += sizeof(mipsu_prof_magic);
+
+    /* every count takes a byte, which bounds the word count */
+    if (!mipsu_get_var(&d, e, &v) || v != mipsu_prof_version ||
+        !mipsu_get_var(&d, e, &w) || w > n)
+        return MIPSU_RESULT_BAD_PROF;
+
+    r = mipsu_prof_alloc(p, w);
+    if (r) return r;
+
+    if (!mipsu_get_var(&d, e, &p->n)) return MIPSU_RESULT_BAD_PROF;
+
+    for (i = 0; i < w; ++i)
+        if (!mipsu_get_var(&d, e, p->hits + i)) return MIPSU_RESULT_BAD_PROF;
+
+    if (!mipsu_get_var(&d, e, &c)) return MIPSU_RESULT_BAD_PROF;
+
+    for (i = k = 0; i < c; ++i) {
+        if (!mipsu_get_var(&d, e, &v) || (k += v) >= w)
+            return MIPSU_RESULT_BAD_PROF;
+        if (!mipsu_get_var(&d, e, p->taken + k)) return MIPSU_RESULT_BAD_PROF;
+    }
+
+    if (!mipsu_get_var(&d, e, &c)) return MIPSU_RESULT_BAD_PROF;
+
+    for (i = 0; i < c; ++i) {
+        if (!mipsu_get_var(&d, e, &k) || k >= 128)
+            return MIPSU_RESULT_BAD_PROF;
+        if (!mipsu_get_var(&d, e, p->instr + k)) return MIPSU_RESULT_BAD_PROF;
+    }
+
+    return d == e ? MIPSU_RESULT_OK : MIPSU_RESULT_BAD_PROF;
+}
+
+static mipsu_result_t mipsu_prof_load(mipsu_prof_t* p, const char* s) {
+    file_t*        f = fopen(s, "rb");
+    uint8_t*       d = NULL;
+    size_t         n = 0;
+    mipsu_result_t r;
+
+    memset(p, 0, sizeof(mipsu_prof_t));
+
+    if (!f) return MIPSU_RESULT_OPEN_FILE;
+
+    r = mipsu_file_size(f, &n);
+
+    if (!r && !(d = malloc(n + 1))) r = MIPSU_RESULT_BUFF_OVERFLOW;
+    if (!r && fread(d, 1, n, f) != n) r = MIPSU_RESULT_READ_FILE;
+    if (!r) r = mipsu_prof_parse(p, d, n);
+    if (r) mipsu_prof_free(p);
+
+    free(d);
+    fclose(f);
+
+    return r;
+}
+
+/* hits, taken for branches, then the usual disassembly */
+static void mipsu_dump_prof(mipsu_word_t w, mipsu_prof_t* f, mipsu_cli_t c) {
+    size_t k  = f->k++;
+    bool_t in = k < f->words;
+    char*  p  = mipsu_dump_begin(c);
+
+    p    = mipsu_put_cnt(p, in ? f->hits[k] : 0, mipsu_cnt_width);
+    *p++ = ' ';
+
+    if (mipsu_is_branch(mipsu_instr_idx(w)))
+        p = mipsu_put_cnt(p, in ? f->taken[k] : 0, mipsu_cnt_width);
+    else
+        p = mipsu_put_chr(p, ' ', mipsu_cnt_width);
+
+    p = mipsu_put_chr(p, ' ', 2);
+
+    if (!mipsu_get_flag(c, MIPSU_FLAG_QUIET)) {
+        p = mipsu_put_hex(p, w, 8);
+        p = mipsu_put_chr(p, ' ', 2);
+    }
+
+    p += mipsu_disasm(w, p, mipsu_lib(c));
+    mipsu_dump_end(p, c);
+}
+
+static void mipsu_dump_mix(const mipsu_prof_t* f, mipsu_cli_t c) {
+    char*  p;
+    size_t i;
+
+    if (mipsu_get_flag(c, MIPSU_FLAG_QUIET)) return;
+
+    p = mipsu_dump_begin(c);
+    p = mipsu_put_str(p, "--------\n");
+    p = mipsu_put_stat(p, "instrs", f->n);
+    mipsu_dump_end(p, c);
+
+    for (i = 0; i < 128; ++i) {
+        if (!f->instr[i] || !mipsu_instr_lut[i].len) continue;
+
+        p = mipsu_dump_begin(c);
+        p = mipsu_put_stat(p, mipsu_instr_lut[i].mnem, f->instr[i]);
+        mipsu_dump_end(p, c);
+    }
+}
+
+static mipsu_result_t mipsu_prof_words(const mipsu_word_t* w, size_t n,
+                                       mipsu_prof_t* f, mipsu_cli_t c) {
+    mipsu_result_t r = mipsu_check_words(w, n, c);
+    size_t         i;
+
+    if (r) return r;
+
+    for (i = 0; i < n; ++i)
+        mipsu_dump_prof(w[i], f, c);
+
+    return MIPSU_RESULT_OK;
+}
+
+/* === Debugging === */
+
+static const uint32_t mipsu_watch_max = 16;
+static const size_t   mipsu_list_ctx  = 2;
+
+/* runs the word at pc alone, past any breakpoint on it */
+static void mipsu_emu_step(mipsu_cpu_t* m) {
+    uint32_t o = m->pc - mipsu_text_base;
+
+    if (o >= m->text || o & 3) {
+        if (o != m->text) mipsu_trap(m, MIPSU_RESULT_EMU_PC);
+        m->run = false;
+        return;
+    }
+
+    m->cur = m->pc;
+    m->pc  = m->npc;
+    m->npc = m->pc + mipsu_word_size;
+
+    mipsu_exec_lut[m->pre[o >> 2].h](m, m->pre + (o >> 2));
+    m->r[0] = 0;
+    ++m->n;
+
+    if (m->dirty) mipsu_text_sync(m);
+}
+
+/* steps off a breakpoint and out of any delay slot, then runs blocks */
+static void mipsu_emu_cont(mipsu_cpu_t* m) {
+    do
+        mipsu_emu_step(m);
+    while (m->run && m->npc != m->pc + mipsu_word_size);
+
+    if (m->run) mipsu_emu_loop(m);
+}
+
+/* delay slots run unchecked as part of their branch's block */
+static mipsu_result_t mipsu_bp_set(mipsu_cpu_t* m, uint32_t a, bool_t on) {
+    uint32_t o = a - mipsu_text_base, k = o >> 2;
+
+    if (o >= m->text || o & 3) return MIPSU_RESULT_BAD_BREAK;
+    if (k && mipsu_is_branch(m->pre[k - 1].h)) return MIPSU_RESULT_BAD_BREAK;
+
+    if (!m->bp) {
+        m->bp = calloc((m->text >> 8) + 1, sizeof(uint64_t));
+        if (!m->bp) return MIPSU_RESULT_BUFF_OVERFLOW;
+    }
+
+    if (on)
+        m->bp[k >> 6] |= (uint64_t)1 << (k & 63);
+    else
+        m->bp[k >> 6] &= ~((uint64_t)1 << (k & 63));
+
+    /* linked blocks never pass through mipsu_block_at */
+    mipsu_block_drop(m, k, k);
+
+    return MIPSU_RESULT_OK;
+}
+
+/* watched pages leave the page caches, so every access to them misses */
+static mipsu_result_t mipsu_watch_set(mipsu_cpu_t* m, uint32_t a, bool_t on) {
+    uint32_t i, t;
+
+    a &= ~(uint32_t)3;
+
+    for (i = 0; i < m->watchc && m->watchv[i] != a; ++i)
+        ;
+
+    if (on && i == m->watchc) {
+        if (i == mipsu_watch_max) return MIPSU_RESULT_TOO_MANY_WATCH;
+
+        if (!m->mem.watch) {
+            m->mem.watch = calloc(1 << (32 - mipsu_page_bits - 5), 4);
+            if (!m->mem.watch) return MIPSU_RESULT_BUFF_OVERFLOW;
+        }
+
+        m->watchv[m->watchc++] = a;
+    } else if (!on && i < m->watchc)
+        m->watchv[i] = m->watchv[--m->watchc];
+
+    if (!m->mem.watch) return MIPSU_RESULT_OK;
+
+    t = a >> mipsu_page_bits;
+    m->mem.watch[t >> 5] &= ~(1u << (t & 31));
+
+    for (i = 0; i < m->watchc; ++i) {
+        t = m->watchv[i] >> mipsu_page_bits;
+        m->mem.watch[t >> 5] |= 1u << (t & 31);
+    }
+
+    memset(m->mem.tag, 0xFF, sizeof(m->mem.tag));
+    memset(m->mem.wtag, 0xFF, sizeof(m->mem.wtag));
+
+    return MIPSU_RESULT_OK;
+}
+
+/* reads memory without mapping pages or tripping watches */
+static bool_t mipsu_peek(const mipsu_cpu_t* m, uint32_t a, mipsu_word_t* w) {
+    uint8_t** t = m->mem.dir[a >> (mipsu_page_bits + mipsu_table_bits)];
+    uint8_t*  p;
+
+    if (!t || a < mipsu_text_base) return false;
+
+    p = t[(a >> mipsu_page_bits) & ((1 << mipsu_table_bits) - 1)];
+    if (!p) return false;
+
+    memcpy(w, p + (a & (mipsu_page_size - 1) & ~3), mipsu_word_size);
+    return true;
+}
+
+/* '=>' marks pc, the next word to run */
+static void mipsu_dump_list(const mipsu_cpu_t* m, size_t k, mipsu_cli_t c) {
+    uint32_t     o = m->pc - mipsu_text_base, a, e;
+    mipsu_word_t w;
+    char*        p;
+
+    if (o >= m->text || o & 3) return;
+
+    a = o > k << 2 ? m->pc - (k << 2) : mipsu_text_base;
+    e = m->text - o > k << 2 ? m->pc + (k << 2) : mipsu_text_base + m->text - 4;
+
+    for (; a <= e; a += mipsu_word_size) {
+        if (!mipsu_peek(m, a, &w)) break;
+
+        p = mipsu_dump_begin(c);
+        p = mipsu_put_str(p, a == m->pc ? "=> " : "   ");
+        p = mipsu_put_hex(p, a, 8);
+        p = mipsu_put_chr(p, ' ', 2);
+
+        if (!mipsu_get_flag(c, MIPSU_FLAG_QUIET)) {
+            p = mipsu_put_hex(p, w, 8);
+            p = mipsu_put_chr(p, ' ', 2);
+        }
+
+        p += mipsu_disasm(w, p, mipsu_lib(c));
+        mipsu_dump_end(p, c);
+    }
+}
+
+static void mipsu_dump_peek(const mipsu_cpu_t* m, uint32_t a, uint32_t n,
+                            mipsu_cli_t c) {
+    mipsu_word_t w;
+    char*        p;
+
+    for (a &= ~(uint32_t)3; n; --n, a += mipsu_word_size) {
+        p = mipsu_dump_begin(c);
+        p = mipsu_put_hex(p, a, 8);
+        p = mipsu_put_chr(p, ' ', 2);
+        p = mipsu_peek(m, a, &w) ? mipsu_put_hex(p, w, 8)
+                                 : mipsu_put_str(p, "--------");
+        *p++ = '\n';
+        mipsu_dump_end(p, c);
+    }
+}
+
+/* why the last command stopped; false once the program is over */
+static bool_t mipsu_dump_stop(const mipsu_cpu_t* m, mipsu_cli_t c) {
+    char  v[11];
+    char* p;
+
+    if (m->res) {
+        *mipsu_put_hex(v, m->cur, 8) = 0;
+        mipsu_errv("trap at", v, c);
+        mipsu_wrnr(m->res, c);
+        return false;
+    }
+
+    if (m->run || m->broke || m->watched) {
+        if (m->watched) {
+            p    = mipsu_dump_begin(c);
+            p    = mipsu_put_pad(p, "watch", mipsu_mnem_width);
+            p    = mipsu_put_hex(p, m->hit, 8);
+            *p++ = '\n';
+            mipsu_dump_end(p, c);
+        }
+
+        mipsu_dump_list(m, 0, c);
+        return true;
+    }
+
+    p    = mipsu_dump_begin(c);
+    p    = mipsu_put_pad(p, "exit", mipsu_mnem_width);
+    p    = mipsu_put_dec(p, m->code, mipsu_cnt_width);
+    *p++ = '\n';
+    p    = mipsu_put_stat(p, "instrs", m->n);
+    mipsu_dump_end(p, c);
+
+    return false;
+}
+
+/*
+ * b/d <addr>: set or delete a breakpoint, w/u <addr>: watch or unwatch a
+ * word, c: continue, s [n]: step, l: list, r: registers, x <addr> [n]:
+ * examine words, k [file]: snapshot, saved to file if given, z: restore
+ * it, q: quit. Sets *live false once the program is over, true on restore.
+ */
+static mipsu_result_t mipsu_debug_cmd(mipsu_cpu_t* m, size_t n,
+                                      const char** a, bool_t* live,
+                                      mipsu_cli_t c) {
+    mipsu_word_t   v = 0, k = 1;
+    mipsu_result_t r;
+
+    if (!n) return MIPSU_RESULT_OK;
+    if (a[0][1] || n > 3) return MIPSU_RESULT_BAD_DEBUG;
+
+    if (a[0][0] == 'k') {
+        if (n > 2) return MIPSU_RESULT_BAD_ARGC;
+        if (!*live) return MIPSU_RESULT_EMU_DONE;
+        if ((r = mipsu_snap_take(m))) return r;
+        return n > 1 ? mipsu_snap_save(m, a[1]) : MIPSU_RESULT_OK;
+    }
+
+    if (a[0][0] == 'z') {
+        if (n > 1) return MIPSU_RESULT_BAD_ARGC;
+        if ((r = mipsu_snap_restore(m))) return r;
+
+        *live = true;
+        mipsu_dump_list(m, 0, c);
+        return MIPSU_RESULT_OK;
+    }
+
+    if (n > 1 && (r = mipsu_parse_word(a[1], &v))) return r;
+    if (n > 2 && (r = mipsu_parse_word(a[2], &k))) return r;
+
+    switch (a[0][0]) {
+    case 'b':
+    case 'd':
+        if (n != 2) return MIPSU_RESULT_BAD_ARGC;
+        return mipsu_bp_set(m, v, a[0][0] == 'b');
+    case 'w':
+    case 'u':
+        if (n != 2) return MIPSU_RESULT_BAD_ARGC;
+        return mipsu_watch_set(m, v, a[0][0] == 'w');
+    case 'x':
+        if (n < 2) return MIPSU_RESULT_BAD_ARGC;
+        mipsu_dump_peek(m, v, k, c);
+        return MIPSU_RESULT_OK;
+    case 'l':
+        mipsu_dump_list(m, mipsu_list_ctx, c);
+        return MIPSU_RESULT_OK;
+    case 'r':
+        mipsu_dump_cpu(m, c);
+        return MIPSU_RESULT_OK;
+    case 'c':
+    case 's':
+        break;
+    default:
+        return MIPSU_RESULT_BAD_DEBUG;
+    }
+
+    if (!*live) return MIPSU_RESULT_EMU_DONE;
+
+    m->run     = true;
+    m->broke   = false;
+    m->watched = false;
+
+    if (a[0][0] == 'c')
+        mipsu_emu_cont(m);
+    else
+        for (k = n > 1 ? v : 1; k && m->run; --k)
+            mipsu_emu_step(m);
+
+    *live = mipsu_dump_stop(m, c);
+
+    return MIPSU_RESULT_OK;
+}
+
+/* === Assembling files === */
+
+/*
+ * The next line in l, and its tokens as spans in a; *n counts them all,
+ * even past m. Tokens end at '#', the line at '\n' or the end of the
+ * buffer. Nothing is copied or written. False once the buffer is read.
+ */
+static bool_t mipsu_lex_line(mipsu_lex_t* x, mipsu_span_t* l,
+                             mipsu_span_t* a, size_t m, size_t* n) {
+    char*   p = x->p;
+    char*   t;
+    uint8_t k;
+
+    if (p == x->e) return false;
+
+    *n   = 0;
+    l->s = p;
+
+    while (p < x->e && (k = mipsu_chr_lut[(uint8_t)*p]) != MIPSU_CHR_EOL) {
+        if (k == MIPSU_CHR_COMMENT) {
+            p = memchr(p, '\n', x->e - p);
+            if (!p) p = x->e;
+            break;
+        }
+
+        if (k == MIPSU_CHR_SEP) {
+            ++p;
+            continue;
+        }
+
+        for (t = p; p < x->e && !mipsu_chr_lut[(uint8_t)*p]; ++p)
+            ;
+
+        if (*n < m) {
+            a[*n].s = t;
+            a[*n].n = p - t;
+        }
+
+        ++*n;
+    }
+
+    l->n = p - l->s;
+    x->p = p < x->e ? p + 1 : p;
+
+    return true;
+}
+
+static mipsu_result_t mipsu_unit_emit(mipsu_unit_t* u, mipsu_word_t w) {
+    mipsu_words_t* s = u->sects + u->cur;
+
+    if (!mipsu_grow((void**)&s->w, s->n, &s->cap, mipsu_word_size))
+        return MIPSU_RESULT_BUFF_OVERFLOW;
+
+    s->w[s->n++] = w;
+
+    return MIPSU_RESULT_OK;
+}
+
+static void mipsu_unit_free(mipsu_unit_t* u) {
+    free(u->sects[0].w);
+    free(u->sects[1].w);
+    free(u->labels);
+    free(u->slots);
+    free(u->names);
+    free(u->fixups);
+}
+
+static uint32_t* mipsu_unit_slot(const mipsu_unit_t* u, const char* s,
+                                 size_t n) {
+    size_t               m = ((size_t)1 << u->bits) - 1;
+    size_t               i = mipsu_hash(s, n, mipsu_label_seed, u->bits);
+    const mipsu_label_t* l;
+
+    for (;; i = (i + 1) & m) {
+        if (!u->slots[i]) return u->slots + i;
+
+        l = u->labels + u->slots[i] - 1;
+        if (l->len == n && !memcmp(u->names + l->name, s, n))
+            return u->slots + i;
+    }
+}
+
+/* doubles the table, keeping it at most half full */
+static bool_t mipsu_unit_rehash(mipsu_unit_t* u) {
+    uint32_t*      v = u->slots;
+    uint8_t        b = u->bits;
+    mipsu_label_t* l;
+    size_t         i;
+
+    u->bits  = b ? b + 1 : 10;
+    u->slots = calloc((size_t)1 << u->bits, sizeof(uint32_t));
+
+    if (!u->slots) {
+        u->slots = v;
+        u->bits  = b;
+        return false;
+    }
+
+    for (i = 0; i < u->labelc; ++i) {
+        l = u->labels + i;
+        *mipsu_unit_slot(u, u->names + l->name, l->len) = i + 1;
+    }
+
+    free(v);
+    return true;
+}
+
+/* the label named by the n chars at s, added undefined if new */
+static mipsu_result_t mipsu_unit_label(mipsu_unit_t* u, const char* s,
+                                       size_t n, uint32_t* k) {
+    uint32_t*      t;
+    mipsu_label_t* l;
+
+    if (2 * (u->labelc + 1) > ((size_t)1 << u->bits) &&
+        !mipsu_unit_rehash(u))
+        return MIPSU_RESULT_BUFF_OVERFLOW;
+
+    t = mipsu_unit_slot(u, s, n);
+
+    if (*t) {
+        *k = *t - 1;
+        return MIPSU_RESULT_OK;
+    }
+
+    while (u->namen + n > u->namecap)
+        if (!mipsu_grow((void**)&u->names, u->namecap, &u->namecap, 1))
+            return MIPSU_RESULT_BUFF_OVERFLOW;
+
+    if (!mipsu_grow((void**)&u->labels, u->labelc, &u->labelcap,
+                    sizeof(mipsu_label_t)))
+        return MIPSU_RESULT_BUFF_OVERFLOW;
+
+    l       = u->labels + u->labelc;
+    l->name = u->namen;
+    l->len  = n;
+    l->sect = mipsu_sects;
+
+    memcpy(u->names + u->namen, s, n);
+    u->namen += n;
+
+    *t = ++u->labelc;
+    *k = u->labelc - 1;
+
+    return MIPSU_RESULT_OK;
+}
+
+static mipsu_result_t mipsu_unit_define(mipsu_unit_t* u, const char* s,
+                                        size_t n) {
+    mipsu_result_t r;
+    uint32_t       k;
+
+    r = mipsu_unit_label(u, s, n, &k);
+    if (r) return r;
+
+    if (u->labels[k].sect != mipsu_sects) return MIPSU_RESULT_DUP_LABEL;
+
+    u->labels[k].sect = u->cur;
+    u->labels[k].off  = u->sects[u->cur].n * mipsu_word_size;
+
+    return MIPSU_RESULT_OK;
+}
+
+/* a reference from the next word to be emitted */
+static mipsu_result_t mipsu_unit_refer(mipsu_unit_t* u, const char* s,
+                                       mipsu_fix_t f) {
+    mipsu_fixup_t* x;
+    mipsu_result_t r;
+    uint32_t       k;
+
+    r = mipsu_unit_label(u, s, strlen(s), &k);
+    if (r) return r;
+
+    if (!mipsu_grow((void**)&u->fixups, u->fixupc, &u->fixupcap,
+                    sizeof(mipsu_fixup_t)))
+        return MIPSU_RESULT_BUFF_OVERFLOW;
+
+    x        = u->fixups + u->fixupc++;
+    x->off   = u->sects[u->cur].n * mipsu_word_size;
+    x->label = k;
+    x->sect  = u->cur;
+    x->fix   = f;
+
+    return MIPSU_RESULT_OK;
+}
+
+/* numbers start with a digit or a sign, registers with '$' */
+static bool_t mipsu_is_label(const char* s) {
+    return *s && !mipsu_dec_digit(*s) && *s != '-' && *s != '+' && *s != '$';
+}
+
+/* %hi(l), %lo(l) anywhere, and bare labels as branch and jump targets */
+static mipsu_result_t mipsu_unit_instr(mipsu_unit_t* u, size_t n,
+                                       const char** a, mipsu_cli_t c) {
+    const char*      v[mipsu_lex_max];
+    const char*      l = NULL;
+    mipsu_fix_t      x = MIPSU_FIX_WORD;
+    mipsu_op_entry_t e;
+    mipsu_field_t    f;
+    mipsu_result_t   r;
+    uint8_t          op;
+    size_t           i, k = 0;
+
+    if (n > mipsu_lex_max) return MIPSU_RESULT_INSTR_SIZE;
+
+    r = mipsu_parse_op(a[0], &e, &op);
+    if (r) return r;
+
+    for (i = 0; i < n; ++i) {
+        if (i + 1 < n && (!strcmp(a[i], "%hi") || !strcmp(a[i], "%lo"))) {
+            x      = a[i][1] == 'h' ? MIPSU_FIX_HI : MIPSU_FIX_LO;
+            l      = a[++i];
+            v[k++] = mipsu_label_hole;
+        } else if (i && i + 1 == n && mipsu_is_label(a[i]) &&
+                   (e.fmt == MIPSU_OP_FMT_ADDR ||
+                    e.fmt == MIPSU_OP_FMT_RS_IMM ||
+                    e.fmt == MIPSU_OP_FMT_RS_RT_IMM)) {
+            x      = e.fmt == MIPSU_OP_FMT_ADDR ? MIPSU_FIX_JUMP
+                                                : MIPSU_FIX_BRANCH;
+            l      = a[i];
+            v[k++] = mipsu_label_hole;
+        } else
+            v[k++] = a[i];
+    }
+
+    r = mipsu_asm_args(k, v, &f, mipsu_lib(c));
+    if (r) return r;
+
+    if (l && (r = mipsu_unit_refer(u, l, x))) return r;
+
+    return mipsu_unit_emit(u, mipsu_encode(f));
+}
+
+/* .text, .data, .word <value | label>..., .align <log2 bytes> */
+static mipsu_result_t mipsu_unit_dir(mipsu_unit_t* u, size_t n,
+                                     const char** a) {
+    mipsu_word_t   w;
+    mipsu_result_t r;
+    size_t         i;
+
+    if (!strcmp(a[0], ".text") || !strcmp(a[0], ".data")) {
+        if (n != 1) return MIPSU_RESULT_TOO_MANY_ARGS;
+        u->cur = a[0][1] == 't' ? mipsu_sect_text : mipsu_sect_data;
+        return MIPSU_RESULT_OK;
+    }
+
+    if (!strcmp(a[0], ".word")) {
+        if (n < 2) return MIPSU_RESULT_MISSING_ARGS;
+
+        for (i = 1; i < n; ++i) {
+            w = 0;
+
+            if (mipsu_is_label(a[i]))
+                r = mipsu_unit_refer(u, a[i], MIPSU_FIX_WORD);
+            else
+                r = mipsu_parse_value(a[i], &w, false, 32);
+
+            if (!r) r = mipsu_unit_emit(u, w);
+            if (r) return r;
+        }
+
+        return MIPSU_RESULT_OK;
+    }
+
+    if (!strcmp(a[0], ".align")) {
+        if (n != 2) return MIPSU_RESULT_BAD_ARGC;
+
+        r = mipsu_parse_value(a[1], &w, true, 5);
+        if (r) return r;
+        if (w > mipsu_align_max) return MIPSU_RESULT_FIELD_OVERFLOW;
+
+        /* data follows text, so its start is aligned to its largest need */
+        w = ((mipsu_word_t)1 << w) / mipsu_word_size;
+        if (w && u->cur == mipsu_sect_data && w > u->align) u->align = w;
+
+        while (w && u->sects[u->cur].n % w)
+            if ((r = mipsu_unit_emit(u, 0))) return r;
+
+        return MIPSU_RESULT_OK;
+    }
+
+    return MIPSU_RESULT_BAD_DIRECTIVE;
+}
+
+/*
+ * labels first, each ending in ':', then a directive or an instruction; v
+ * has room for the n tokens' strings
+ */
+static mipsu_result_t mipsu_unit_line(mipsu_unit_t* u, const mipsu_span_t* a,
+                                      size_t n, const char** v,
+                                      mipsu_cli_t c) {
+    mipsu_result_t r;
+    size_t         i, k;
+
+    for (i = 0; i < n && a[i].n > 1 && a[i].s[a[i].n - 1] == ':'; ++i) {
+        if (!mipsu_is_label(a[i].s)) return MIPSU_RESULT_BAD_LABEL;
+
+        r = mipsu_unit_define(u, a[i].s, a[i].n - 1);
+        if (r) return r;
+    }
+
+    if (i == n) return MIPSU_RESULT_OK;
+
+    for (k = i; k < n; ++k)
+        v[k - i] = a[k].s;
+
+    if (*v[0] == '.') return mipsu_unit_dir(u, n - i, v);
+
+    return mipsu_unit_instr(u, n - i, v, c);
+}
+
+/* the address of data, then every reference patched in */
+static mipsu_result_t mipsu_unit_link(mipsu_unit_t* u, mipsu_cli_t c) {
+    const mipsu_fixup_t* x;
+    const mipsu_label_t* l;
+    mipsu_word_t*        w;
+    mipsu_result_t       r = MIPSU_RESULT_OK, q;
+    uint32_t             base[2], a, pc;
+    int32_t              d;
+    size_t               i, k = u->sects[0].n;
+    char                 v[256];
+
+    for (; u->align && k % u->align; ++k)
+        ;
+
+    base[mipsu_sect_text] = mipsu_text_base;
+    base[mipsu_sect_data] = mipsu_text_base + k * mipsu_word_size;
+
+    for (i = 0; i < u->fixupc; ++i) {
+        x  = u->fixups + i;
+        l  = u->labels + x->label;
+        w  = u->sects[x->sect].w + x->off / mipsu_word_size;
+        pc = base[x->sect] + x->off;
+        q  = MIPSU_RESULT_OK;
+
+        if (l->sect == mipsu_sects) {
+            q = MIPSU_RESULT_BAD_LABEL;
+        } else {
+            a = base[l->sect] + l->off;
+
+            switch (x->fix) {
+            case MIPSU_FIX_BRANCH:
+                d = (int32_t)(a - pc - mipsu_word_size) >> 2;
+                if (d < INT16_MIN || d > INT16_MAX)
+                    q = MIPSU_RESULT_FIELD_OVERFLOW;
+                *w |= (uint32_t)d & mipsu_16bit_mask;
+                break;
+            case MIPSU_FIX_JUMP:
+                if ((a ^ (pc + mipsu_word_size)) & 0xF0000000)
+                    q = MIPSU_RESULT_FIELD_OVERFLOW;
+                *w |= (a >> 2) & mipsu_26bit_mask;
+                break;
+            case MIPSU_FIX_HI:
+                *w |= ((a + 0x8000) >> 16) & mipsu_16bit_mask;
+                break;
+            case MIPSU_FIX_LO:
+                *w |= a & mipsu_16bit_mask;
+                break;
+            case MIPSU_FIX_WORD:
+                *w = a;
+                break;
+            }
+        }
+
+        if (!q) continue;
+
+        k = l->len < sizeof(v) ? l->len : sizeof(v) - 1;
+        memcpy(v, u->names + l->name, k);
+        v[k] = 0;
+
+        mipsu_wrnrv(q, v, c);
+
+        if (mipsu_get_flag(c, MIPSU_FLAG_STRICT)) return q;
+
+        r = MIPSU_RESULT_SKIPPED;
+    }
+
+    return r;
+}
+
+static void mipsu_unit_dump(const mipsu_unit_t* u, mipsu_cli_t c) {
+    const mipsu_words_t* t = u->sects + mipsu_sect_text;
+    const mipsu_words_t* d = u->sects + mipsu_sect_data;
+    size_t               i;
+
+    if (mipsu_get_flag(c, MIPSU_FLAG_QUIET))
+        mipsu_dump_words(t->w, t->n, c);
+    else
+        for (i = 0; i < t->n; ++i)
+            mipsu_dump_instr(t->w[i], c);
+
+    for (i = t->n; d->n && u->align && i % u->align; ++i)
+        mipsu_dump_word(0, c);
+
+    mipsu_dump_words(d->w, d->n, c);
+}
+
+/* === Benchmarking === */
+
+static uint32_t mipsu_bench_rand(uint32_t* s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+
+    return *s;
+}
+
+/* every named entry of mipsu_instr_lut in turn, random in the fields used */
+static void mipsu_bench_corpus(mipsu_word_t* w, size_t n) {
+    uint32_t    s = mipsu_bench_seed, r;
+    uint8_t     e[128];
+    size_t      i, k, m = 0;
+    const char* t;
+
+    for (i = 0; i < 128; ++i)
+        if (mipsu_instr_lut[i].len) e[m++] = i;
+
+    for (i = k = 0; i < n; ++i, k = (k + 1) % m) {
+        r    = mipsu_bench_rand(&s);
+        w[i] = e[k] < 64 ? e[k] : (mipsu_word_t)(e[k] - 64) << mipsu_op_offset;
+
+        for (t = mipsu_tmpl_lut[mipsu_instr_lut[e[k]].fmt]; *t; ++t) {
+            switch (*t) {
+            case 's':
+            case 'S':
+                w[i] |= r & mipsu_5bit_mask << mipsu_rs_offset;
+                break;
+            case 't':
+                w[i] |= r & mipsu_5bit_mask << mipsu_rt_offset;
+                break;
+            case 'd':
+                w[i] |= r & mipsu_5bit_mask << mipsu_rd_offset;
+                break;
+            case 'h':
+                w[i] |= r & mipsu_5bit_mask << mipsu_sh_offset;
+                break;
+            case 'i':
+            case 'o':
+                w[i] |= r & mipsu_16bit_mask;
+                break;
+            case 'a':
+                w[i] |= r & mipsu_26bit_mask;
+                break;
+            }
+        }
+    }
+}
+
+static void mipsu_bench_decode(mipsu_bench_t* b, mipsu_cli_t c) {
+    size_t i;
+
+    for (i = 0; i < b->n; ++i)
+        b->f[i] = mipsu_decode(b->w[i]);
+
+    (void)c;
+}
+
+static void mipsu_bench_disasm(mipsu_bench_t* b, mipsu_cli_t c) {
+    char   l[MIPSU_LINE_MAX];
+    size_t i;
+
+    for (i = 0; i < b->n; ++i)
+        b->sink += mipsu_disasm(b->w[i], l, mipsu_lib(c));
+}
+
+static void mipsu_bench_fmt(mipsu_bench_t* b, mipsu_cli_t c) {
+    char   l[MIPSU_LINE_MAX];
+    size_t i;
+
+    for (i = 0; i < b->n; ++i)
+        b->sink += mipsu_fmt_field(b->w[i], b->f[i], l, mipsu_lib(c));
+}
+
+static void mipsu_bench_asm(mipsu_bench_t* b, mipsu_cli_t c) {
+    mipsu_field_t f;
+    size_t        i;
+
+    for (i = 0; i < b->n; ++i)
+        b->sink +=
+            mipsu_asm(b->t + i * mipsu_bench_stride, &f, mipsu_lib(c)) + f.op;
+}
+
+static void mipsu_bench_encode(mipsu_bench_t* b, mipsu_cli_t c) {
+    size_t i;
+
+    for (i = 0; i < b->n; ++i)
+        b->sink += mipsu_encode(b->f[i]);
+
+    (void)c;
+}
+
+/* decode runs first, as fmt_field and encode read the fields it writes */
+static const mipsu_bench_path_t mipsu_bench_lut[] = {
+    {"decode", mipsu_bench_decode},
+    {"disasm", mipsu_bench_disasm},
+    {"fmt_field", mipsu_bench_fmt},
+    {"asm", mipsu_bench_asm},
+    {"encode", mipsu_bench_encode},
+};
+
+static uint64_t mipsu_bench_now(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+/* one tab separated row per path, after a header naming the columns */
+static void mipsu_dump_bench(const char* k, size_t n, uint64_t ns,
+                             mipsu_cli_t c) {
+    uint64_t q = ns ? ns : 1;
+    char*    p = mipsu_dump_begin(c);
+
+    p    = mipsu_put_str(p, k);
+    *p++ = '\t';
+    p    = mipsu_put_cnt(p, n, 0);
+    *p++ = '\t';
+    p    = mipsu_put_cnt(p, ns, 0);
+    *p++ = '\t';
+    p    = mipsu_put_cnt(p, (uint64_t)n * 1000000000 / q, 0);
+    *p++ = '\t';
+    p    = mipsu_put_cnt(p, ns / n, 0);
+    *p++ = '.';
+    p    = mipsu_put_cnt(p, ns * 100 / n / 10 % 10, 0);
+    p    = mipsu_put_cnt(p, ns * 100 / n % 10, 0);
+    *p++ = '\n';
+
+    mipsu_dump_end(p, c);
+}
+
+static mipsu_result_t mipsu_bench(size_t n, mipsu_cli_t c) {
+    mipsu_bench_t b;
+    uint64_t      t, m;
+    size_t        i, k;
+    char*         p;
+
+    b.n    = n;
+    b.sink = 0;
+    b.w    = malloc(n * mipsu_word_size);
+    b.f    = malloc(n * sizeof(mipsu_field_t));
+    b.t    = malloc(n * mipsu_bench_stride);
+
+    if (!b.w || !b.f || !b.t) {
+        free(b.w);
+        free(b.f);
+        free(b.t);
+        return MIPSU_RESULT_BUFF_OVERFLOW;
+    }
+
+    mipsu_bench_corpus(b.w, n);
+
+    for (i = 0; i < n; ++i)
+        mipsu_disasm(b.w[i], b.t + i * mipsu_bench_stride, mipsu_lib(c));
+
+    p = mipsu_dump_begin(c);
+    p = mipsu_put_str(p, "path\twords\tns\twords_per_s\tns_per_word\n");
+    mipsu_dump_end(p, c);
+
+    for (k = 0; k < sizeof(mipsu_bench_lut) / sizeof(*mipsu_bench_lut); ++k) {
+        for (i = 0, m = (uint64_t)-1; i < mipsu_bench_reps; ++i) {
+            t = mipsu_bench_now();
+            mipsu_bench_lut[k].run(&b, c);
+            t = mipsu_bench_now() - t;
+
+            if (t < m) m = t;
+        }
+
+        mipsu_dump_bench(mipsu_bench_lut[k].name, n, m, c);
+    }
+
+    free(b.w);
+    free(b.f);
+    free(b.t);
+
+    mipsu_bench_sink = b.sink;
+
+    return MIPSU_RESULT_OK;
+}
+
+/* hex words, or raw with --raw, for other tools to time on */
+static mipsu_result_t mipsu_corpus(size_t n, mipsu_cli_t c) {
+    mipsu_word_t* w;
+
+    if (mipsu_tty(c.o) && mipsu_get_flag(c, MIPSU_FLAG_RAW))
+        return MIPSU_RESULT_RAW_STDOUT;
+
+    w = malloc(n * mipsu_word_size);
+    if (!w) return MIPSU_RESULT_BUFF_OVERFLOW;
+
+    mipsu_bench_corpus(w, n);
+    mipsu_dump_words(w, n, c);
+
+    free(w);
+
+    return MIPSU_RESULT_OK;
+}
+
+/* === Sweeping === */
+
+static void* mipsu_job_sweep(void* p) {
+    mipsu_sweep_t* j = p;
+    char           l[MIPSU_LINE_MAX];
+    mipsu_field_t  f;
+    uint64_t       a, e, i;
+    mipsu_word_t   w;
+    size_t         x;
+    bool_t         k;
+
+    for (a = j->lo + j->first * mipsu_sweep_chunk; a < j->hi;
+         a += j->step * mipsu_sweep_chunk) {
+        e = j->hi - a < mipsu_sweep_chunk ? j->hi : a + mipsu_sweep_chunk;
+
+        for (i = a; i < e; ++i) {
+            w = (mipsu_word_t)i;
+            x = mipsu_instr_idx(w);
+
+            if (!mipsu_instr_lut[x].len) {
+                ++j->n[2];
+                j->miss[x] += !mipsu_verify(w);
+                continue;
+            }
+
+            mipsu_disasm(w, l, j->c);
+            k = !mipsu_asm(l, &f, j->c) && mipsu_encode(f) == w;
+
+            if (k) {
+                ++j->canon[x];
+                j->used[x] |= w;
+            }
+
+            ++j->n[!k];
+            j->miss[x] += k != !mipsu_verify(w);
+        }
+    }
+
+    return NULL;
+}
+
+/* op, and fn for R-type, which every word of instruction x shares */
+static mipsu_word_t mipsu_sweep_fixed(size_t x) {
+    mipsu_word_t op = (mipsu_word_t)mipsu_6bit_mask << mipsu_op_offset;
+
+    return x < 64 ? op | mipsu_6bit_mask : op;
+}
+
+static uint8_t mipsu_popcount(mipsu_word_t w) {
+    uint8_t n = 0;
+
+    for (; w; w &= w - 1)
+        ++n;
+
+    return n;
+}
+
+static char* mipsu_put_legal(char* p, size_t x, mipsu_word_t m) {
+    p    = mipsu_put_str(p, x < 64 ? "    [MIPSU_FN(" : "    [MIPSU_OP(");
+    p    = mipsu_put_hex(p, x % 64, 2);
+    p    = mipsu_put_str(p, ")] = ");
+    p    = mipsu_put_hex(p, m, 8);
+    p    = mipsu_put_str(p, ", /* ");
+    p    = mipsu_put_str(p, mipsu_instr_lut[x].mnem);
+    p    = mipsu_put_str(p, " */\n");
+
+    return p;
+}
+
+/*
+ * Every word of ops [lo, hi) through decode, disasm, asm and encode, on
+ * c.jobs threads or one per core. Prints the counts, then mipsu_legal_lut
+ * as found. An instruction whose canonical words are not all those within
+ * its mask is irregular, and no mask can tell them apart.
+ */
+static mipsu_result_t mipsu_sweep(uint8_t lo, uint8_t hi, mipsu_cli_t c) {
+    mipsu_sweep_t* v;
+    uint64_t       n[3] = {}, canon, miss = 0, odd = 0;
+    mipsu_word_t   used;
+    size_t         i, x, k = c.jobs;
+    char*          p;
+    long           cpus;
+
+    if (k < 2 && (cpus = sysconf(_SC_NPROCESSORS_ONLN)) > 0)
+        k = (size_t)cpus < mipsu_job_max ? (size_t)cpus : mipsu_job_max;
+    if (!k) k = 1;
+
+    v = calloc(k, sizeof(mipsu_sweep_t));
+    if (!v) return MIPSU_RESULT_BUFF_OVERFLOW;
+
+    for (i = 0; i < k; ++i) {
+        v[i].c.flags = 0;
+        v[i].lo      = (uint64_t)lo << mipsu_op_offset;
+        v[i].hi      = (uint64_t)hi << mipsu_op_offset;
+        v[i].first   = i;
+        v[i].step    = k;
+
+        v[i].live = !pthread_create(&v[i].t, NULL, mipsu_job_sweep, v + i);
+        if (!v[i].live) mipsu_job_sweep(v + i);
+    }
+
+    for (i = 0; i < k; ++i)
+        if (v[i].live) pthread_join(v[i].t, NULL);
+
+    for (i = 1; i < k; ++i)
+        for (x = 0; x < 128; ++x) {
+            v->canon[x] += v[i].canon[x];
+            v->miss[x] += v[i].miss[x];
+            v->used[x] |= v[i].used[x];
+        }
+
+    for (i = 0; i < k; ++i)
+        for (x = 0; x < 3; ++x)
+            n[x] += v[i].n[x];
+
+    for (x = 0; x < 128; ++x) {
+        used  = v->used[x];
+        canon = (uint64_t)1 << mipsu_popcount(used & ~mipsu_sweep_fixed(x));
+
+        miss += v->miss[x];
+        odd += v->canon[x] && v->canon[x] != canon;
+    }
+
+    p = mipsu_dump_begin(c);
+    p = mipsu_put_stat(p, "canon", n[0]);
+    p = mipsu_put_stat(p, "legal", n[1]);
+    p = mipsu_put_stat(p, "unknown", n[2]);
+    p = mipsu_put_stat(p, "odd", odd);
+    p = mipsu_put_stat(p, "stale", miss);
+    p = mipsu_put_str(p, "--------\n");
+    mipsu_dump_end(p, c);
+
+    for (x = 0; x < 128; ++x) {
+        if (!v->canon[x]) continue;
+
+        p = mipsu_dump_begin(c);
+        p = mipsu_put_legal(p, x, v->used[x]);
+        mipsu_dump_end(p, c);
+    }
+
+    free(v);
+
+    return miss ? MIPSU_RESULT_BAD_SWEEP : MIPSU_RESULT_OK;
+}
+
+/* === Caching === */
+
+static uint64_t mipsu_fnv(uint64_t h, uint32_t v) {
+    return (h ^ v) * mipsu_fnv_prime;
+}
+
+/* the words, where they are and how they are listed, by which version */
+static uint64_t mipsu_page_key(const mipsu_word_t* w, size_t n, uint32_t a,
+                               mipsu_cli_t c) {
+    const char* v = MIPSU_VERSION;
+    uint64_t    h = mipsu_fnv_basis;
+    size_t      i;
+
+    for (; *v; ++v)
+        h = mipsu_fnv(h, (uint8_t)*v);
+
+    h = mipsu_fnv(h, c.flags & mipsu_cache_flags);
+    h = mipsu_fnv(h, a);
+    h = mipsu_fnv(h, n);
+
+    for (i = 0; i < n; ++i)
+        h = mipsu_fnv(h, w[i]);
+
+    return h;
+}
+
+static mipsu_result_t mipsu_cache_open(mipsu_cache_t* k, const char* d) {
+    struct stat st;
+    size_t      n = strlen(d);
+
+    memset(k, 0, sizeof(mipsu_cache_t));
+
+    mkdir(d, 0777);
+    if (stat(d, &st) || !S_ISDIR(st.st_mode)) return MIPSU_RESULT_BAD_CACHE;
+
+    k->n      = n + 1;
+    k->path   = malloc(k->n + 16 + 1);
+    k->tmp    = malloc(k->n + 16 + 5);
+    k->b.cap  = mipsu_cache_page * (mipsu_word_size + mipsu_line_max);
+    k->b.data = malloc(k->b.cap);
+
+    if (!k->path || !k->tmp || !k->b.data) return MIPSU_RESULT_BUFF_OVERFLOW;
+
+    memcpy(k->path, d, n);
+    k->path[n] = '/';
+
+    return MIPSU_RESULT_OK;
+}
+
+static void mipsu_cache_close(mipsu_cache_t* k) {
+    free(k->path);
+    free(k->tmp);
+    free(k->b.data);
+}
+
+static void mipsu_cache_name(mipsu_cache_t* k, uint64_t h) {
+    char*  p = k->path + k->n;
+    size_t i;
+
+    for (i = 16; i; --i, h >>= 4)
+        p[i - 1] = mipsu_hexit_lut[h & 0xF];
+    p[16] = 0;
+
+    memcpy(k->tmp, k->path, k->n + 16);
+    memcpy(k->tmp + k->n + 16, ".tmp", 5);
+}
+
+/* reads the named entry into b, true if it is for the n words at w */
+static bool_t mipsu_cache_get(mipsu_cache_t* k, const mipsu_word_t* w,
+                              size_t n) {
+    file_t* f = fopen(k->path, "r");
+
+    if (!f) return false;
+
+    k->b.n = fread(k->b.data, 1, k->b.cap, f);
+    fclose(f);
+
+    return k->b.n >= n * mipsu_word_size &&
+           !memcmp(k->b.data, w, n * mipsu_word_size);
+}
+
+/* best effort: an entry not written is only listed again next time */
+static void mipsu_cache_put(mipsu_cache_t* k) {
+    file_t* f = fopen(k->tmp, "w");
+    bool_t  ok;
+
+    if (!f) return;
+
+    ok = fwrite(k->b.data, 1, k->b.n, f) == k->b.n;
+
+    if (fclose(f) || !ok || rename(k->tmp, k->path)) remove(k->tmp);
+}
+
+/*
+ * Lists n words at a a page at a time, copying the listings of pages seen
+ * before from k and keeping those of the others there.
+ */
+static mipsu_result_t mipsu_cache_words(mipsu_cache_t* k,
+                                        const mipsu_word_t* w, size_t n,
+                                        uint32_t a, mipsu_cli_t c) {
+    mipsu_cli_t    pc = c;
+    mipsu_result_t r;
+    size_t         i, m, o;
+
+    pc.o    = NULL;
+    pc.b    = &k->b;
+    pc.jobs = 0;
+
+    for (i = 0; i < n; i += m) {
+        m = n - i < mipsu_cache_page ? n - i : mipsu_cache_page;
+        o = m * mipsu_word_size;
+
+        mipsu_cache_name(k, mipsu_page_key(w + i, m, a, c));
+
+        if (!mipsu_cache_get(k, w + i, m)) {
+            memcpy(k->b.data, w + i, o);
+            k->b.n = o;
+
+            r = mipsu_disasm_words(w + i, m, a, pc);
+            if (r) return r;
+
+            mipsu_cache_put(k);
+        }
+
+        mipsu_flush(c);
+        fwrite(k->b.data + o, 1, k->b.n - o, c.o);
+
+        a += o;
+    }
+
+    return MIPSU_RESULT_OK;
+}
+
+/* === Diffing === */
+
+static void mipsu_dump_change(char k, mipsu_word_t w, mipsu_cli_t c) {
+    char* p = mipsu_dump_begin(c);
+
+    *p++ = k;
+    p    = mipsu_put_hex(p, w, 8);
+    p    = mipsu_put_chr(p, ' ', 2);
+    p += mipsu_disasm(w, p, mipsu_lib(c));
+    mipsu_dump_end(p, c);
+}
+
+/* '@@ <address> -<old words> +<new words> @@', then the words of each */
+static void mipsu_dump_hunk(const mipsu_word_t* u, size_t un,
+                            const mipsu_word_t* v, size_t vn, uint32_t a,
+                            mipsu_cli_t c) {
+    char*  p = mipsu_dump_begin(c);
+    bool_t s = mipsu_swapped(c);
+    size_t i;
+
+    p = mipsu_put_str(p, "@@ ");
+    p = mipsu_put_hex(p, a, 8);
+    p = mipsu_put_str(p, " -");
+    p = mipsu_put_cnt(p, un, 0);
+    p = mipsu_put_str(p, " +");
+    p = mipsu_put_cnt(p, vn, 0);
+    p = mipsu_put_str(p, " @@\n");
+    mipsu_dump_end(p, c);
+
+    for (i = 0; i < un; ++i)
+        mipsu_dump_change('-', s ? mipsu_swap(u[i]) : u[i], c);
+    for (i = 0; i < vn; ++i)
+        mipsu_dump_change('+', s ? mipsu_swap(v[i]) : v[i], c);
+}
+
+/*
+ * Runs of words that differ between two raw images, as hunks placed from
+ * 0x00400000; pages the same in both are passed over whole, so the words
+ * disassembled are only those that changed.
+ */
+static mipsu_result_t mipsu_diff(const mipsu_src_t* o, const mipsu_src_t* w,
+                                 mipsu_cli_t c) {
+    const mipsu_word_t* u  = (const mipsu_word_t*)o->data;
+    const mipsu_word_t* v  = (const mipsu_word_t*)w->data;
+    const size_t        pw = mipsu_cache_page;
+
+    size_t un = o->size / mipsu_word_size, vn = w->size / mipsu_word_size;
+    size_t n  = un < vn ? un : vn, i, j;
+
+    for (i = 0; i < n;) {
+        if (!(i % pw) && n - i >= pw &&
+            !memcmp(u + i, v + i, pw * mipsu_word_size)) {
+            i += pw;
+            continue;
+        }
+
+        if (u[i] == v[i]) {
+            ++i;
+            continue;
+        }
+
+        for (j = i; j < n && u[j] != v[j]; ++j)
+            ;
+
+        mipsu_dump_hunk(u + i, j - i, v + i, j - i,
+                        mipsu_text_base + i * mipsu_word_size, c);
+        i = j;
+    }
+
+    if (un != vn)
+        mipsu_dump_hunk(u + n, un - n, v + n, vn - n,
+                        mipsu_text_base + n * mipsu_word_size, c);
+
+    return (o->size | w->size) % mipsu_word_size ? MIPSU_RESULT_SKIPPED
+                                                 : MIPSU_RESULT_OK;
+}
+
+/* === Control flow === */
+
+/* the target of a branch or jump at a; jr and jalr have none */
+static bool_t mipsu_target(mipsu_word_t w, uint32_t a, uint32_t* t) {
+    uint32_t d = a + mipsu_word_size;
+
+    switch (mipsu_instr_idx(w)) {
+    case MIPSU_OP(0x02):
+    case MIPSU_OP(0x03):
+        *t = (d & 0xF0000000) | mipsu_addr(w) << 2;
+        return true;
+    case MIPSU_OP(0x04):
+    case MIPSU_OP(0x05):
+    case MIPSU_OP(0x06):
+    case MIPSU_OP(0x07):
+        *t = d + ((uint32_t)(int32_t)mipsu_imm(w) << 2);
+        return true;
+    default:
+        return false;
+    }
+}
+
+static int mipsu_cmp_addr(const void* x, const void* y) {
+    uint32_t u = *(const uint32_t*)x, v = *(const uint32_t*)y;
+
+    return (u > v) - (u < v);
+}
+
+/* sorts v and drops repeats, returning how many are left */
+static size_t mipsu_uniq(uint32_t* v, size_t n) {
+    size_t i, k = 0;
+
+    qsort(v, n, sizeof(uint32_t), mipsu_cmp_addr);
+
+    for (i = 0; i < n; ++i)
+        if (!k || v[k - 1] != v[i]) v[k++] = v[i];
+
+    return k;
+}
+
+static bool_t mipsu_has_addr(const uint32_t* v, size_t n, uint32_t a) {
+    return n && bsearch(&a, v, n, sizeof(uint32_t), mipsu_cmp_addr);
+}
+
+static void mipsu_cfg_free(mipsu_cfg_t* g) {
+    free(g->t);
+    free(g->l);
+}
+
+/*
+ * One pass over the words, ending blocks where the emulator does, after a
+ * branch's delay slot; then every target starts a block as well.
+ */
+static mipsu_result_t mipsu_cfg_build(mipsu_cfg_t* g, const mipsu_word_t* w,
+                                      size_t n, uint32_t a) {
+    uint32_t s = n * mipsu_word_size, b, t;
+    size_t   i;
+
+    memset(g, 0, sizeof(mipsu_cfg_t));
+
+    g->w = w;
+    g->n = n;
+    g->a = a;
+    g->t = malloc((n + 1) * sizeof(uint32_t));
+    g->l = malloc((2 * n + 1) * sizeof(uint32_t));
+
+    if (!g->t || !g->l) return MIPSU_RESULT_BUFF_OVERFLOW;
+
+    if (n) g->l[g->ln++] = a;
+
+    for (i = 0; i < n; ++i) {
+        if (!mipsu_is_branch(mipsu_instr_idx(w[i]))) continue;
+
+        b = i * mipsu_word_size;
+
+        if (b + 2 * mipsu_word_size < s) g->l[g->ln++] = a + b + 8;
+        if (mipsu_target(w[i], a + b, &t) && t - a < s && !(t & 3))
+            g->t[g->tn++] = t;
+    }
+
+    g->tn = mipsu_uniq(g->t, g->tn);
+
+    memcpy(g->l + g->ln, g->t, g->tn * sizeof(uint32_t));
+    g->ln = mipsu_uniq(g->l, g->ln + g->tn);
+
+    return MIPSU_RESULT_OK;
+}
+
+/* the word ending the block of words [k, e) with a branch, or e */
+static size_t mipsu_cfg_exit(const mipsu_cfg_t* g, size_t k, size_t e) {
+    if (e - k >= 2 && mipsu_is_branch(mipsu_instr_idx(g->w[e - 2])))
+        return e - 2;
+    if (mipsu_is_branch(mipsu_instr_idx(g->w[e - 1]))) return e - 1;
+
+    return e;
+}
+
+static char* mipsu_put_label(char* p, uint32_t a) {
+    size_t i;
+
+    *p++ = 'L';
+    *p++ = '_';
+
+    for (i = 8; i; --i, a >>= 4)
+        p[i - 1] = mipsu_hexit_lut[a & 0xF];
+
+    return p + 8;
+}
+
+/* disasm with targets in text named by their labels */
+static void mipsu_dump_cfg_word(const mipsu_cfg_t* g, size_t i,
+                                mipsu_cli_t c) {
+    uint32_t     a = g->a + i * mipsu_word_size, t;
+    mipsu_word_t w = g->w[i];
+    char *       p = mipsu_dump_begin(c), *s;
+
+    if (!mipsu_get_flag(c, MIPSU_FLAG_QUIET)) {
+        p = mipsu_put_hex(p, a, 8);
+        p = mipsu_put_chr(p, ' ', 2);
+        p = mipsu_put_hex(p, w, 8);
+        p = mipsu_put_chr(p, ' ', 2);
+    }
+
+    s = p;
+    p += mipsu_disasm(w, p, mipsu_lib(c));
+
+    /* the target is the last operand, and is never padded */
+    if (mipsu_target(w, a, &t) && mipsu_has_addr(g->t, g->tn, t)) {
+        for (--p; p > s && p[-1] != ' '; --p)
+            ;
+        p    = mipsu_put_label(p, t);
+        *p++ = '\n';
+    }
+
+    mipsu_dump_end(p, c);
+}
+
+/* a blank line before every block, and a label for those jumped to */
+static void mipsu_dump_cfg_words(const mipsu_cfg_t* g, mipsu_cli_t c) {
+    uint32_t a;
+    size_t   i, j = 0;
+    char*    p;
+
+    for (i = 0; i < g->n; ++i) {
+        a = g->a + i * mipsu_word_size;
+
+        if (j < g->ln && g->l[j] == a) {
+            ++j;
+            p = mipsu_dump_begin(c);
+
+            if (i) *p++ = '\n';
+
+            if (mipsu_has_addr(g->t, g->tn, a)) {
+                p    = mipsu_put_label(p, a);
+                *p++ = ':';
+                *p++ = '\n';
+            }
+
+            mipsu_dump_end(p, c);
+        }
+
+        mipsu_dump_cfg_word(g, i, c);
+    }
+}
+
+/*
+ * The successors of the block of words [k, e), -1 where there is none:
+ * where its branch jumps, when known, and the word after the delay slot,
+ * unless the branch is j or jr. Calls return there, so jal and jalr keep it.
+ */
+static void mipsu_cfg_succ(const mipsu_cfg_t* g, size_t k, size_t e,
+                           int64_t* jump, int64_t* next) {
+    size_t   x = mipsu_cfg_exit(g, k, e);
+    uint32_t t;
+
+    *jump = *next = -1;
+
+    if (x == e) {
+        if (e < g->n) *next = g->a + e * mipsu_word_size;
+        return;
+    }
+
+    if (mipsu_target(g->w[x], g->a + x * mipsu_word_size, &t)) *jump = t;
+
+    switch (mipsu_instr_idx(g->w[x])) {
+    case MIPSU_FN(0x08):
+    case MIPSU_OP(0x02):
+        return;
+    default:
+        if (x + 2 < g->n) *next = g->a + (x + 2) * mipsu_word_size;
+    }
+}
+
+static uint64_t mipsu_prof_at(const mipsu_prof_t* f, const uint64_t* v,
+                              uint32_t a) {
+    uint32_t k = (a - mipsu_text_base) / mipsu_word_size;
+
+    return f && k < f->words ? v[k] : 0;
+}
+
+static char* mipsu_put_node(char* p, uint32_t a) {
+    *p++ = '"';
+    p    = mipsu_put_label(p, a);
+    *p++ = '"';
+
+    return p;
+}
+
+static void mipsu_dump_dot_block(const mipsu_cfg_t* g, size_t k, size_t e,
+                                 const mipsu_prof_t* f, mipsu_cli_t c) {
+    uint32_t a = g->a + k * mipsu_word_size;
+    uint32_t x = g->a + mipsu_cfg_exit(g, k, e) * mipsu_word_size;
+    int64_t  jump, next;
+    char*    p = mipsu_dump_begin(c);
+
+    mipsu_cfg_succ(g, k, e, &jump, &next);
+
+    p = mipsu_put_str(p, "    ");
+    p = mipsu_put_node(p, a);
+    p = mipsu_put_str(p, " [label=\"");
+    p = mipsu_put_label(p, a);
+    p = mipsu_put_str(p, "\\n");
+    p = mipsu_put_cnt(p, e - k, 0);
+    p = mipsu_put_str(p, " words");
+
+    if (f) {
+        p = mipsu_put_str(p, "\\n");
+        p = mipsu_put_cnt(p, mipsu_prof_at(f, f->hits, a), 0);
+        p = mipsu_put_str(p, " hits");
+    }
+
+    p = mipsu_put_str(p, "\"];\n");
+
+    if (jump >= 0 && (uint32_t)jump - g->a < g->n * mipsu_word_size) {
+        p = mipsu_put_str(p, "    ");
+        p = mipsu_put_node(p, a);
+        p = mipsu_put_str(p, " -> ");
+        p = mipsu_put_node(p, jump);
+        p = mipsu_put_str(p, " [label=\"jump");
+        if (f) {
+            *p++ = ' ';
+            p    = mipsu_put_cnt(p, mipsu_prof_at(f, f->taken, x), 0);
+        }
+        p = mipsu_put_str(p, "\"];\n");
+    }
+
+    if (next >= 0) {
+        p = mipsu_put_str(p, "    ");
+        p = mipsu_put_node(p, a);
+        p = mipsu_put_str(p, " -> ");
+        p = mipsu_put_node(p, next);
+        p = mipsu_put_str(p, " [label=\"next\"];\n");
+    }
+
+    mipsu_dump_end(p, c);
+}
+
+static char* mipsu_put_jaddr(char* p, const char* k, int64_t a) {
+    p = mipsu_put_jkey(p, k);
+
+    return a < 0 ? mipsu_put_str(p, "null") : mipsu_put_cnt(p, a, 0);
+}
+
+static void mipsu_dump_json_block(const mipsu_cfg_t* g, size_t k, size_t e,
+                                  const mipsu_prof_t* f, mipsu_cli_t c) {
+    uint32_t a = g->a + k * mipsu_word_size;
+    uint32_t x = g->a + mipsu_cfg_exit(g, k, e) * mipsu_word_size;
+    int64_t  jump, next;
+    char*    p = mipsu_dump_begin(c);
+
+    mipsu_cfg_succ(g, k, e, &jump, &next);
+
+    p = mipsu_put_str(p, "{\"at\":");
+    p = mipsu_put_cnt(p, a, 0);
+    p = mipsu_put_jkey(p, "words");
+    p = mipsu_put_cnt(p, e - k, 0);
+    p = mipsu_put_jaddr(p, "jump", jump);
+    p = mipsu_put_jaddr(p, "next", next);
+
+    if (f) {
+        p = mipsu_put_jkey(p, "hits");
+        p = mipsu_put_cnt(p, mipsu_prof_at(f, f->hits, a), 0);
+        p = mipsu_put_jkey(p, "jumps");
+        p = mipsu_put_cnt(p, mipsu_prof_at(f, f->taken, x), 0);
+    }
+
+    p = mipsu_put_str(p, "}\n");
+    mipsu_dump_end(p, c);
+}
+
+/* DOT, or one JSON object per block with --format=jsonl */
+static void mipsu_dump_cfg(const mipsu_cfg_t* g, const mipsu_prof_t* f,
+                           mipsu_cli_t c) {
+    bool_t json = mipsu_get_flag(c, MIPSU_FLAG_JSONL);
+    size_t i, k, e;
+    char*  p;
+
+    if (!json) {
+        p = mipsu_dump_begin(c);
+        p = mipsu_put_str(p, "digraph cfg {\n    node [shape=box];\n");
+        mipsu_dump_end(p, c);
+    }
+
+    for (i = 0; i < g->ln; ++i) {
+        k = (g->l[i] - g->a) / mipsu_word_size;
+        e = i + 1 < g->ln ? (g->l[i + 1] - g->a) / mipsu_word_size : g->n;
+
+        if (json)
+            mipsu_dump_json_block(g, k, e, f, c);
+        else
+            mipsu_dump_dot_block(g, k, e, f, c);
+    }
+
+    if (!json) {
+        p = mipsu_dump_begin(c);
+        p = mipsu_put_str(p, "}\n");
+        mipsu_dump_end(p, c);
+    }
+}
+
+/* === Timing === */
+
+/*
+ * Latencies of a classic five stage pipeline with forwarding, by flavour:
+ * cycles a load lags behind an ALU result, cycles HI and LO stay busy on
+ * mult and div, and cycles a branch or jr waits on any operand, as they
+ * read registers in decode.
+ */
+static const mipsu_lat_t mipsu_lat_lut[] = {
+    {"r3000", 1, 12, 35, 1},
+};
+
+static const mipsu_lat_t* const mipsu_lat = mipsu_lat_lut;
+
+static bool_t mipsu_is_load(size_t x) {
+    return x >= MIPSU_OP(0x20) && x <= MIPSU_OP(0x25);
+}
+
+static bool_t mipsu_is_hilo(size_t x) {
+    return x >= MIPSU_FN(0x10) && x <= MIPSU_FN(0x1B);
+}
+
+static void mipsu_time_ready(mipsu_timing_t* s, uint8_t r, uint32_t t) {
+    if (r) s->ready[r] = t;
+}
+
+/* when a word issued at u or later, lagging b, can read r; 0 is no write */
+static uint32_t mipsu_time_read(const mipsu_timing_t* s, uint8_t r,
+                                uint32_t b, uint32_t u) {
+    uint32_t k = s->ready[r] ? s->ready[r] + b : 0;
+
+    return r && k > u ? k : u;
+}
+
+/*
+ * Issues w once what it reads is ready, returning the cycles it stalled
+ * and why; HI and LO stay busy for any word reading or writing them.
+ */
+static uint32_t mipsu_time_word(mipsu_timing_t* s, mipsu_word_t w,
+                                const char** why) {
+    const mipsu_op_entry_t* e = mipsu_instr(w);
+    const mipsu_lat_t*      l = mipsu_lat;
+    size_t                  x = mipsu_instr_idx(w);
+    uint32_t                b = mipsu_is_branch(x) ? l->branch : 0;
+    uint32_t                u = s->t, k;
+    uint8_t                 rs = mipsu_rs(w), rt = mipsu_rt(w);
+
+    if (e->use & MIPSU_ROLE_RS) u = mipsu_time_read(s, rs, b, u);
+    if (e->use & MIPSU_ROLE_RT) u = mipsu_time_read(s, rt, b, u);
+
+    *why = u == s->t ? "" : b ? "branch" : "load";
+
+    if (mipsu_is_hilo(x) && s->ready[32] > u) {
+        u    = s->ready[32];
+        *why = "hilo";
+    }
+
+    k = u + 1 + (mipsu_is_load(x) ? l->load : 0);
+
+    if (e->def & MIPSU_ROLE_RT) mipsu_time_ready(s, rt, k);
+    if (e->def & MIPSU_ROLE_RD) mipsu_time_ready(s, mipsu_rd(w), k);
+    if (e->def & MIPSU_ROLE_RA) mipsu_time_ready(s, 31, k);
+
+    if (x == MIPSU_FN(0x18) || x == MIPSU_FN(0x19))
+        s->ready[32] = u + l->mult;
+    else if (x == MIPSU_FN(0x1A) || x == MIPSU_FN(0x1B))
+        s->ready[32] = u + l->div;
+    else if (x == MIPSU_FN(0x11) || x == MIPSU_FN(0x13))
+        s->ready[32] = u + 1;
+
+    k    = u - s->t;
+    s->t = u + 1;
+
+    return k;
+}
+
+/* what each word costs, and why, then the block's cycles */
+static void mipsu_dump_timed(mipsu_word_t w, uint32_t k, const char* why,
+                             mipsu_cli_t c) {
+    char* p = mipsu_dump_begin(c);
+
+    p    = mipsu_put_cnt(p, k + 1, mipsu_dec_width);
+    *p++ = ' ';
+    p    = mipsu_put_pad(p, why, mipsu_mnem_width);
+    p    = mipsu_put_chr(p, ' ', 2);
+
+    if (!mipsu_get_flag(c, MIPSU_FLAG_QUIET)) {
+        p = mipsu_put_hex(p, w, 8);
+        p = mipsu_put_chr(p, ' ', 2);
+    }
+
+    p += mipsu_disasm(w, p, mipsu_lib(c));
+    mipsu_dump_end(p, c);
+}
+
+static void mipsu_dump_time_block(uint32_t a, const mipsu_timing_t* s,
+                                  const uint64_t* v, mipsu_cli_t c) {
+    char* p = mipsu_dump_begin(c);
+
+    if (mipsu_get_flag(c, MIPSU_FLAG_JSONL)) {
+        p = mipsu_put_str(p, "{\"at\":");
+        p = mipsu_put_cnt(p, a, 0);
+        p = mipsu_put_jkey(p, "words");
+        p = mipsu_put_cnt(p, s->words - v[0], 0);
+        p = mipsu_put_jkey(p, "stalls");
+        p = mipsu_put_cnt(p, s->stalls - v[1], 0);
+        p = mipsu_put_jkey(p, "slots");
+        p = mipsu_put_cnt(p, s->slots - v[2], 0);
+        p = mipsu_put_jkey(p, "cycles");
+        p = mipsu_put_cnt(p, s->t, 0);
+        p = mipsu_put_str(p, "}\n");
+    } else if (mipsu_get_flag(c, MIPSU_FLAG_ANNOTATE))
+        p = mipsu_put_stat(p, "cycles", s->t);
+    else {
+        p    = mipsu_put_label(p, a);
+        p    = mipsu_put_cnt(p, s->words - v[0], mipsu_dec_width + 2);
+        p    = mipsu_put_cnt(p, s->stalls - v[1], mipsu_dec_width + 1);
+        p    = mipsu_put_cnt(p, s->slots - v[2], mipsu_dec_width + 1);
+        p    = mipsu_put_cnt(p, s->t, mipsu_cnt_width);
+        *p++ = '\n';
+    }
+
+    mipsu_dump_end(p, c);
+}
+
+/*
+ * Times the block of words [k, e) from an empty pipeline, adding to the
+ * totals in s; a nop after a branch is an unfilled delay slot.
+ */
+static void mipsu_time_block(const mipsu_cfg_t* g, size_t k, size_t e,
+                             mipsu_timing_t* s, mipsu_cli_t c) {
+    bool_t      list = mipsu_get_flag(c, MIPSU_FLAG_ANNOTATE) &&
+                  !mipsu_get_flag(c, MIPSU_FLAG_JSONL);
+    uint64_t    v[3];
+    const char* why;
+    uint32_t    n;
+    size_t      i;
+    char*       p;
+
+    v[0] = s->words;
+    v[1] = s->stalls;
+    v[2] = s->slots;
+
+    memset(s->ready, 0, sizeof(s->ready));
+    s->t = 0;
+
+    if (list) {
+        p = mipsu_dump_begin(c);
+        if (k) *p++ = '\n';
+        p    = mipsu_put_label(p, g->a + k * mipsu_word_size);
+        *p++ = ':';
+        *p++ = '\n';
+        mipsu_dump_end(p, c);
+    }
+
+    for (i = k; i < e; ++i) {
+        n = mipsu_time_word(s, g->w[i], &why);
+
+        if (!g->w[i] && i > k &&
+            mipsu_is_branch(mipsu_instr_idx(g->w[i - 1]))) {
+            ++s->slots;
+            why = "slot";
+        }
+
+        s->stalls += n;
+        ++s->words;
+
+        if (list) mipsu_dump_timed(g->w[i], n, why, c);
+    }
+
+    ++s->blocks;
+    mipsu_dump_time_block(g->a + k * mipsu_word_size, s, v, c);
+}
+
+/* a row per block, or its words with what each costs given --annotate */
+static void mipsu_dump_timing(const mipsu_cfg_t* g, mipsu_cli_t c) {
+    mipsu_timing_t s;
+    size_t         i, k, e;
+    char*          p;
+
+    memset(&s, 0, sizeof(mipsu_timing_t));
+
+    if (!mipsu_get_flag(c, MIPSU_FLAG_QUIET | MIPSU_FLAG_JSONL |
+                               MIPSU_FLAG_ANNOTATE)) {
+        p = mipsu_dump_begin(c);
+        p = mipsu_put_str(p, "block        words stalls  slots      cycles\n");
+        mipsu_dump_end(p, c);
+    }
+
+    for (i = 0; i < g->ln; ++i) {
+        k = (g->l[i] - g->a) / mipsu_word_size;
+        e = i + 1 < g->ln ? (g->l[i + 1] - g->a) / mipsu_word_size : g->n;
+
+        mipsu_time_block(g, k, e, &s, c);
+    }
+
+    if (mipsu_get_flag(c, MIPSU_FLAG_JSONL)) return;
+
+    p = mipsu_dump_begin(c);
+    p = mipsu_put_str(p, "--------\n");
+    p = mipsu_put_stat(p, "blocks", s.blocks);
+    p = mipsu_put_stat(p, "words", s.words);
+    p = mipsu_put_stat(p, "stalls", s.stalls);
+    p = mipsu_put_stat(p, "slots", s.slots);
+    p = mipsu_put_stat(p, "cycles", s.words + s.stalls);
+    mipsu_dump_end(p, c);
+}
+
+/* === Batching === */
+
+/* an expected output of "-" is not checked, so none of it is kept */
+static mipsu_result_t mipsu_case_out(const char* s, mipsu_src_t* e) {
+    mipsu_result_t r;
+    file_t*        f;
+
+    memset(e, 0, sizeof(mipsu_src_t));
+
+    if (!strcmp(s, "-")) return MIPSU_RESULT_OK;
+
+    if (!(f = fopen(s, "r"))) return MIPSU_RESULT_OPEN_FILE;
+
+    r = mipsu_src_open(f, e);
+    fclose(f);
+
+    return r;
+}
+
+/*
+ * Runs one case on an emulator of its own, with guest stdout kept in a
+ * buffer one byte longer than expected, so any extra output shows.
+ */
+static void mipsu_case_run(mipsu_case_t* k, const mipsu_image_t* g,
+                           mipsu_cli_t c) {
+    mipsu_cpu_t  m;
+    mipsu_buff_t b = {NULL, 0, 0, 0};
+    mipsu_src_t  e;
+    file_t*      in;
+
+    memset(&m, 0, sizeof(mipsu_cpu_t));
+
+    if ((k->res = g->res) || (k->res = mipsu_case_out(k->out, &e))) return;
+
+    in = fopen(strcmp(k->in, "-") ? k->in : "/dev/null", "r");
+
+    b.cap  = e.size + 1;
+    b.data = malloc(b.cap);
+    c.o    = NULL;
+    c.b    = &b;
+
+    if (!in)
+        k->res = MIPSU_RESULT_OPEN_FILE;
+    else if (!b.data)
+        k->res = MIPSU_RESULT_BUFF_OVERFLOW;
+    else if (mipsu_get_flag(c, MIPSU_FLAG_RESUME))
+        k->res = mipsu_emu_resume(&m, &g->snap, c);
+    else
+        k->res = mipsu_emu_init(&m, g->w, g->n, false, g->pre, c);
+
+    if (!k->res) {
+        m.in = in;
+        mipsu_emu_loop(&m);
+
+        k->res  = m.res;
+        k->code = m.code;
+        k->n    = m.n;
+    }
+
+    if (!k->res && e.data &&
+        (b.n != e.size || memcmp(b.data, e.data, e.size)))
+        k->res = MIPSU_RESULT_RUN_OUTPUT;
+
+    mipsu_emu_free(&m);
+    mipsu_src_close(e);
+    free(b.data);
+    if (in) fclose(in);
+}
+
+static void* mipsu_job_case(void* p) {
+    mipsu_pool_t* q = p;
+    size_t        i;
+
+    for (;;) {
+        pthread_mutex_lock(&q->lock);
+        i = q->next++;
+        pthread_mutex_unlock(&q->lock);
+
+        if (i >= q->n) return NULL;
+
+        mipsu_case_run(q->v + i, q->imgs + q->v[i].img, q->c);
+    }
+}
+
+/*
+ * k workers; those that start take every case between them, and the caller
+ * runs them alone when k is one or none do.
+ */
+static void mipsu_pool_run(mipsu_pool_t* q, size_t k) {
+    pthread_t* t = k > 1 ? malloc(k * sizeof(pthread_t)) : NULL;
+    size_t     i;
+
+    pthread_mutex_init(&q->lock, NULL);
+
+    for (i = 0; t && i < k; ++i)
+        if (pthread_create(t + i, NULL, mipsu_job_case, q)) break;
+
+    if (!i) mipsu_job_case(q);
+
+    while (i)
+        pthread_join(t[--i], NULL);
+
+    pthread_mutex_destroy(&q->lock);
+    free(t);
+}
+
+/* === Command Line Interface === */
+
+static mipsu_result_t mipsu_arg_decode(const char* s, mipsu_cli_t c) {
+    mipsu_word_t   w;
+    mipsu_result_t r;
+
+    if (mipsu_tty(c.o) && mipsu_get_flag(c, MIPSU_FLAG_BIN))
+        return MIPSU_RESULT_RAW_STDOUT;
+
+    r = mipsu_parse_word(s, &w);
+
+    if (r) return r;
+
+    mipsu_dump_decoded(w, c);
+
+    return MIPSU_RESULT_OK;
+}
+
+/* a word count other than the default, for bench and corpus */
+static mipsu_result_t mipsu_parse_count(const char* s, size_t* n) {
+    mipsu_word_t   w;
+    mipsu_result_t r = mipsu_parse_word(s, &w);
+
+    if (r) return r;
+    if (!w) return MIPSU_RESULT_FIELD_OVERFLOW;
+
+    *n = w;
+
+    return MIPSU_RESULT_OK;
+}
+
+static mipsu_result_t mipsu_file_bench(mipsu_cli_t c) {
+    return mipsu_bench(mipsu_bench_words, c);
+}
+
+static mipsu_result_t mipsu_arg_bench(const char* s, mipsu_cli_t c) {
+    size_t         n;
+    mipsu_result_t r = mipsu_parse_count(s, &n);
+
+    return r ? r : mipsu_bench(n, c);
+}
+
+static mipsu_result_t mipsu_file_corpus(mipsu_cli_t c) {
+    return mipsu_corpus(mipsu_bench_words, c);
+}
+
+static mipsu_result_t mipsu_arg_corpus(const char* s, mipsu_cli_t c) {
+    size_t         n;
+    mipsu_result_t r = mipsu_parse_count(s, &n);
+
+    return r ? r : mipsu_corpus(n, c);
+}
+
+static mipsu_result_t mipsu_file_sweep(mipsu_cli_t c) {
+    return mipsu_sweep(0, 64, c);
+}
+
+/* the 2^26 words of one op, R-type being op 0 */
+static mipsu_result_t mipsu_arg_sweep(const char* s, mipsu_cli_t c) {
+    mipsu_word_t   op;
+    mipsu_result_t r = mipsu_parse_value(s, &op, true, 6);
+
+    return r ? r : mipsu_sweep(op, op + 1, c);
+}
+
+static mipsu_result_t mipsu_args_encode(size_t n, const char** args,
+                                        mipsu_cli_t c) {
+
+    mipsu_field_t  f;
+    mipsu_result_t r;
+
+    r = mipsu_parse_field(n, args, &f, c);
+
+    if (!r) mipsu_dump_encoded(f, c);
+
+    return r;
+}
+
+/* f, when given, annotates each word with its profile counts */
+static mipsu_result_t mipsu_raw_disasm(mipsu_prof_t* f, mipsu_cli_t c) {
+    mipsu_cache_t  k;
+    mipsu_stream_t s;
+    mipsu_word_t*  w;
+    mipsu_result_t r;
+    size_t         n;
+    uint32_t       a = mipsu_text_base;
+
+    bool_t cached = c.cache && !f;
+
+    if (cached && (r = mipsu_cache_open(&k, c.cache))) {
+        mipsu_cache_close(&k);
+        return r;
+    }
+
+    r = mipsu_stream_open(&s, c.f);
+
+    while (!r && !(r = mipsu_stream_next(&s, &w, &n, c)) && n) {
+        if (f)
+            r = mipsu_prof_words(w, n, f, c);
+        else if (cached)
+            r = mipsu_cache_words(&k, w, n, a, c);
+        else
+            r = mipsu_disasm_words(w, n, a, c);
+
+        a += n * mipsu_word_size;
+    }
+
+    mipsu_stream_close(&s);
+
+    if (cached) mipsu_cache_close(&k);
+
+    if (r) return r;
+
+    return s.rest ? MIPSU_RESULT_SKIPPED : MIPSU_RESULT_OK;
+}
+
+/*
+ * Every executable section in file order, labelled by the symbols in it.
+ * Profiles index words from 0x00400000, wherever the sections start.
+ */
+static mipsu_result_t mipsu_elf_disasm(mipsu_prof_t* f, mipsu_cli_t c) {
+    mipsu_elf_t      e;
+    mipsu_elf_shdr_t s;
+    const uint8_t*   b;
+    mipsu_word_t     w;
+    mipsu_result_t   r;
+    size_t           i, k, o;
+
+    r = mipsu_elf_open(c.f, &e);
+
+    for (i = 0; !r && i < e.h.shnum; ++i) {
+        mipsu_elf_shdr(&e, i, &s);
+
+        if (s.type != mipsu_elf_sht_progbits || !(s.flags & mipsu_elf_shf_exec))
+            continue;
+
+        b = (const uint8_t*)mipsu_elf_words(&e, s.off, s.size);
+        if (!b) r = MIPSU_RESULT_BAD_ELF;
+
+        if (f) f->k = (s.addr - mipsu_text_base) / mipsu_word_size;
+
+        k = mipsu_sym_find(&e, s.addr);
+
+        for (o = 0; b && o + mipsu_word_size <= s.size; o += mipsu_word_size) {
+            for (; k < e.symc && e.syms[k].addr <= s.addr + o; ++k)
+                if (e.syms[k].addr == s.addr + o && e.syms[k].shndx == i &&
+                    !mipsu_get_flag(c, MIPSU_FLAG_QUIET | MIPSU_FLAG_JSONL |
+                                           MIPSU_FLAG_BIN))
+                    mipsu_dump_label(e.syms[k].name, c);
+
+            memcpy(&w, b + o, mipsu_word_size);
+
+            if ((r = mipsu_check_words(&w, 1, c))) break;
+
+            if (f)
+                mipsu_dump_prof(w, f, c);
+            else
+                mipsu_dump_at(s.addr + o, w, c);
+        }
+    }
+
+    mipsu_elf_close(&e);
+
+    return r;
+}
+
+static mipsu_result_t mipsu_text_disasm(mipsu_prof_t* f, mipsu_cli_t c) {
+    char           l[1024];
+    uint32_t       a = mipsu_text_base;
+    mipsu_word_t   w;
+    bool_t         s = false;
+    mipsu_result_t r;
+
+    while (fgets(l, sizeof(l), c.f)) {
+        l[strcspn(l, "\n")] = 0;
+
+        r = mipsu_parse_word(l, &w);
+
+        if (r) {
+            if (mipsu_get_flag(c, MIPSU_FLAG_STRICT)) return r;
+            mipsu_wrnrv(r, l, c);
+            s = true;
+            continue;
+        }
+
+        if ((r = mipsu_check_words(&w, 1, c))) return r;
+
+        if (f)
+            mipsu_dump_prof(w, f, c);
+        else
+            mipsu_dump_disasm(a, w, c);
+
+        a += mipsu_word_size;
+    }
+
+    return s ? MIPSU_RESULT_SKIPPED : MIPSU_RESULT_OK;
+}
+
+/* eight hexits as written, false unless all of them are hexits */
+#if defined(__SSE2__)
+static bool_t mipsu_hex8(const char* s, mipsu_word_t* w) {
+    __m128i c = _mm_loadl_epi64((const __m128i*)s);
+    __m128i l = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    __m128i d = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                              _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    __m128i a = _mm_and_si128(_mm_cmpgt_epi8(l, _mm_set1_epi8('a' - 1)),
+                              _mm_cmplt_epi8(l, _mm_set1_epi8('f' + 1)));
+    __m128i n;
+
+    if ((_mm_movemask_epi8(_mm_or_si128(d, a)) & 0xFF) != 0xFF) return false;
+
+    /* a nibble per byte, then each pair of them into one byte */
+    n = _mm_add_epi8(_mm_and_si128(c, _mm_set1_epi8(0x0F)),
+                     _mm_and_si128(a, _mm_set1_epi8(9)));
+    n = _mm_or_si128(_mm_slli_epi16(n, 4), _mm_srli_epi16(n, 8));
+    n = _mm_and_si128(n, _mm_set1_epi16(0xFF));
+
+    *w = mipsu_swap((mipsu_word_t)_mm_cvtsi128_si32(_mm_packus_epi16(n, n)));
+
+    return true;
+}
+#elif defined(__ARM_NEON)
+static bool_t mipsu_hex8(const char* s, mipsu_word_t* w) {
+    uint8x8_t  c = vld1_u8((const uint8_t*)s);
+    uint8x8_t  l = vorr_u8(c, vdup_n_u8(0x20));
+    uint8x8_t  d = vand_u8(vcge_u8(c, vdup_n_u8('0')),
+                           vcle_u8(c, vdup_n_u8('9')));
+    uint8x8_t  a = vand_u8(vcge_u8(l, vdup_n_u8('a')),
+                           vcle_u8(l, vdup_n_u8('f')));
+    uint16x4_t n;
+
+    if (vget_lane_u64(vreinterpret_u64_u8(vorr_u8(d, a)), 0) != ~(uint64_t)0)
+        return false;
+
+    n = vreinterpret_u16_u8(vadd_u8(vand_u8(c, vdup_n_u8(0x0F)),
+                                    vand_u8(a, vdup_n_u8(9))));
+    n = vorr_u16(vshl_n_u16(n, 4), vshr_n_u16(n, 8));
+
+    *w = mipsu_swap(vget_lane_u32(
+        vreinterpret_u32_u8(vmovn_u16(vcombine_u16(n, n))), 0));
+
+    return true;
+}
+#else
+static bool_t mipsu_hex8(const char* s, mipsu_word_t* w) {
+    size_t i;
+
+    for (i = 0; i < 8; ++i)
+        if (s[i] != '0' && !mipsu_hex_lut[(uint8_t)s[i]]) return false;
+
+    *w = mipsu_get_value(s, 8, 4);
+
+    return true;
+}
+#endif
+
+static bool_t mipsu_hexit(char c) {
+    return c == '0' || mipsu_hex_lut[(uint8_t)c];
+}
+
+static mipsu_result_t mipsu_hexin_flush(mipsu_hexin_t* x, mipsu_cli_t c) {
+    size_t   n = x->n;
+    uint32_t a = x->a;
+
+    x->n = 0;
+    x->a += n * mipsu_word_size;
+
+    if (mipsu_get_flag(c, MIPSU_FLAG_LE)) mipsu_swap_words(x->w, n);
+
+    return x->f ? mipsu_prof_words(x->w, n, x->f, c)
+                : mipsu_disasm_words(x->w, n, a, c);
+}
+
+static mipsu_result_t mipsu_hexin_push(mipsu_hexin_t* x, mipsu_word_t w,
+                                       mipsu_cli_t c) {
+    x->w[x->n++] = w;
+
+    return x->n == sizeof(x->w) / mipsu_word_size ? mipsu_hexin_flush(x, c)
+                                                  : MIPSU_RESULT_OK;
+}
+
+/* the hexits in [h, p), eight to a word, which groups may straddle */
+static mipsu_result_t mipsu_hexin_put(mipsu_hexin_t* x, const char* h,
+                                      const char* p, mipsu_cli_t c) {
+    mipsu_result_t r;
+    mipsu_word_t   w;
+
+    if (!x->k && p - h == 8 && mipsu_hex8(h, &w))
+        return mipsu_hexin_push(x, w, c);
+
+    for (; h < p; ++h) {
+        x->v = x->v << 4 | mipsu_hex_lut[(uint8_t)*h];
+
+        if (++x->k < 8) continue;
+
+        x->k = 0;
+        r    = mipsu_hexin_push(x, x->v, c);
+        if (r) return r;
+    }
+
+    return MIPSU_RESULT_OK;
+}
+
+/* the next token before t, from *h; gap if a tab or two spaces lead it */
+static char* mipsu_hexin_token(char* p, const char* t, char** h,
+                               bool_t* gap) {
+    *gap = false;
+
+    for (; p < t && mipsu_chr_lut[(uint8_t)*p]; ++p)
+        if (*p == '\t' || (*p == ' ' && p + 1 < t && p[1] == ' ')) *gap = true;
+
+    for (*h = p; p < t && !mipsu_chr_lut[(uint8_t)*p]; ++p)
+        ;
+
+    return p;
+}
+
+/* whether [*h, p) is hexits in pairs, moving *h past any 0x */
+static bool_t mipsu_hexin_group(char** h, const char* p) {
+    char* s = *h;
+
+    if (p - s > 2 && s[0] == '0' && (s[1] | 0x20) == 'x') s += 2;
+
+    if ((p - s) % 2) return false;
+
+    for (*h = s; s < p; ++s)
+        if (!mipsu_hexit(*s)) return false;
+
+    return true;
+}
+
+/*
+ * The first group waits to be told apart from an address without a ':'
+ * by the width of the next, even across a gap, as hexdump -C puts one
+ * there. A group alone is an address, as od and hexdump -C end with. Lines
+ * that do not start with groups are headers or labels, such as objdump's
+ * "00400000 <main>:", and taken as nothing.
+ */
+static mipsu_result_t mipsu_hexin_line(mipsu_hexin_t* x, char* p,
+                                       const char* t, mipsu_cli_t c) {
+    char *         h, *g, *e;
+    bool_t         gap;
+    mipsu_result_t r;
+    mipsu_word_t   w;
+    size_t         n;
+
+    x->k = 0;
+
+    p = mipsu_hexin_token(p, t, &h, &gap);
+    if (h == p) return MIPSU_RESULT_OK;
+
+    if (p[-1] == ':') {
+        p = mipsu_hexin_token(p, t, &h, &gap);
+        if (h == p || !mipsu_hexin_group(&h, p)) return MIPSU_RESULT_OK;
+    } else {
+        if (!mipsu_hexin_group(&h, p)) return MIPSU_RESULT_OK;
+
+        g = h;
+        e = p;
+        p = mipsu_hexin_token(p, t, &h, &gap);
+        if (h == p) return MIPSU_RESULT_OK;
+
+        if (!mipsu_hexin_group(&h, p))
+            return gap ? mipsu_hexin_put(x, g, e, c) : MIPSU_RESULT_OK;
+
+        if (p - h == e - g) {
+            r = mipsu_hexin_put(x, g, e, c);
+            if (r || gap) return r;
+        }
+    }
+
+    for (;;) {
+        n = p - h;
+
+        if (!x->k && n == 8 && mipsu_hex8(h, &w))
+            r = mipsu_hexin_push(x, w, c);
+        else if (mipsu_hexin_group(&h, p))
+            r = mipsu_hexin_put(x, h, p, c);
+        else
+            return MIPSU_RESULT_OK;
+
+        if (r) return r;
+
+        p = mipsu_hexin_token(p, t, &h, &gap);
+        if (h == p || (gap && (size_t)(p - h) != n)) return MIPSU_RESULT_OK;
+    }
+}
+
+/*
+ * Dumps of many words to a line, as xxd, objdump and capture tools write
+ * them. An address column ends in ':', or is wider or narrower than the
+ * groups after it. Groups of hexits, each optionally 0x prefixed, are read
+ * as written, eight hexits to a word; a tab or two spaces after them ends
+ * the line, passing over ASCII and disassembly columns, unless a group as
+ * wide as the last follows, as midway along a hexdump -C line.
+ */
+static mipsu_result_t mipsu_hexdump_disasm(mipsu_prof_t* f, mipsu_cli_t c) {
+    mipsu_hexin_t  x;
+    mipsu_src_t    src;
+    mipsu_result_t r;
+    bool_t         s = false;
+    char *         p, *t, *e;
+
+    r = mipsu_src_open(c.f, &src);
+    if (r) return r;
+
+    x.n = 0;
+    x.a = mipsu_text_base;
+    x.f = f;
+    e   = src.data + src.size;
+
+    for (p = src.data; !r && p < e; p = t + (t < e)) {
+        t = memchr(p, '\n', e - p);
+        if (!t) t = e;
+
+        r = mipsu_hexin_line(&x, p, t, c);
+        if (r || !x.k) continue;
+
+        if (mipsu_get_flag(c, MIPSU_FLAG_STRICT)) {
+            r = MIPSU_RESULT_MISSING_HEXITS;
+        } else {
+            *t = 0;
+            mipsu_wrnrv(MIPSU_RESULT_MISSING_HEXITS, p, c);
+            s = true;
+        }
+    }
+
+    if (!r && x.n) r = mipsu_hexin_flush(&x, c);
+
+    mipsu_src_close(src);
+
+    if (r) return r;
+
+    return s ? MIPSU_RESULT_SKIPPED : MIPSU_RESULT_OK;
+}
+
+static mipsu_result_t mipsu_read_words(mipsu_word_t** w, size_t* n,
+                                       mipsu_cli_t c) {
+    char           l[1024];
+    mipsu_word_t*  t;
+    size_t         cap = 0;
+    mipsu_result_t r;
+
+    *w = NULL;
+    *n = 0;
+
+    while (fgets(l, sizeof(l), c.f)) {
+
+        l[strcspn(l, "\n")] = 0;
+
+        if (!*l) continue;
+
+        if (*n == cap) {
+            cap = cap ? 2 * cap : 1024;
+            t   = realloc(*w, cap * mipsu_word_size);
+            if (!t) return MIPSU_RESULT_BUFF_OVERFLOW;
+            *w = t;
+        }
+
+        /* a skipped word would shift every address after it */
+        r = mipsu_parse_word(l, *w + *n);
+        if (r) {
+            mipsu_errv("in", l, c);
+            return r;
+        }
+
+        ++*n;
+    }
+
+    return MIPSU_RESULT_OK;
+}
+
+/* all of text at once: mapped when raw, to be unmapped through t */
+static mipsu_result_t mipsu_load_words(mipsu_word_t** w, size_t* n,
+                                       mipsu_map_t* t, mipsu_cli_t c) {
+    mipsu_result_t r;
+
+    t->data = NULL;
+    *w      = NULL;
+    *n      = 0;
+
+    if (!mipsu_get_flag(c, MIPSU_FLAG_RAW)) return mipsu_read_words(w, n, c);
+
+    r = mipsu_map_whole(t, c);
+    if (r) return r;
+
+    if (t->size % mipsu_word_size) mipsu_wrnr(MIPSU_RESULT_SKIPPED, c);
+
+    *w = (mipsu_word_t*)t->data;
+    *n = t->size / mipsu_word_size;
+
+    return MIPSU_RESULT_OK;
+}
+
+static void mipsu_unload_words(mipsu_word_t* w, mipsu_map_t t) {
+    if (t.data)
+        mipsu_unmap(t);
+    else
+        free(w);
+}
+
+/* the whole text and its control flow, as a listing or as a graph */
+static mipsu_result_t mipsu_cfg_words(bool_t list, const mipsu_prof_t* f,
+                                      mipsu_cli_t c) {
+    mipsu_cfg_t    g;
+    mipsu_map_t    t;
+    mipsu_word_t*  w;
+    mipsu_result_t r;
+    size_t         n;
+
+    memset(&g, 0, sizeof(mipsu_cfg_t));
+
+    r = mipsu_load_words(&w, &n, &t, c);
+    if (!r) r = mipsu_check_words(w, n, c);
+    if (!r) r = mipsu_cfg_build(&g, w, n, mipsu_text_base);
+
+    if (!r && list)
+        mipsu_dump_cfg_words(&g, c);
+    else if (!r)
+        mipsu_dump_cfg(&g, f, c);
+
+    mipsu_cfg_free(&g);
+    mipsu_unload_words(w, t);
+
+    return r;
+}
+
+static mipsu_result_t mipsu_file_disasm(mipsu_cli_t c) {
+    mipsu_prof_t   p;
+    mipsu_prof_t*  f = NULL;
+    mipsu_result_t r;
+
+    bool_t raw = mipsu_get_flag(c, MIPSU_FLAG_RAW);
+    bool_t elf = mipsu_get_flag(c, MIPSU_FLAG_ELF);
+
+    if (mipsu_tty(c.o) && mipsu_get_flag(c, MIPSU_FLAG_BIN))
+        return MIPSU_RESULT_RAW_STDOUT;
+
+    if (mipsu_get_flag(c, MIPSU_FLAG_DIFF)) return MIPSU_RESULT_MISSING_ARGS;
+
+    if (c.prof) {
+        r = mipsu_prof_load(&p, c.prof);
+        if (r) return r;
+        f = &p;
+    }
+
+    if (elf)
+        r = mipsu_elf_disasm(f, c);
+    else if (mipsu_get_flag(c, MIPSU_FLAG_LABELS) && !f)
+        r = mipsu_cfg_words(true, NULL, c);
+    else if (mipsu_get_flag(c, MIPSU_FLAG_HEXDUMP) && !raw)
+        r = mipsu_hexdump_disasm(f, c);
+    else
+        r = raw ? mipsu_raw_disasm(f, c) : mipsu_text_disasm(f, c);
+
+    if (f) {
+        /* ELF text is only part of what a run loads, so only raw text counts */
+        if (!elf && p.k != p.words) mipsu_wrnr(MIPSU_RESULT_BAD_PROF, c);
+
+        mipsu_dump_mix(&p, c);
+        mipsu_prof_free(&p);
+    }
+
+    return r;
+}
+
+static mipsu_result_t mipsu_raw_stats(mipsu_stats_t* s, mipsu_cli_t c) {
+    mipsu_stream_t t;
+    mipsu_word_t*  w;
+    mipsu_job_t*   v = NULL;
+    mipsu_result_t r;
+    size_t         n, i, k = c.jobs > 1 ? c.jobs : 0;
+
+    if (k && !(v = calloc(k, sizeof(mipsu_job_t))))
+        return MIPSU_RESULT_BUFF_OVERFLOW;
+
+    r = mipsu_stream_open(&t, c.f);
+
+    while (!r && !(r = mipsu_stream_next(&t, &w, &n, c)) && n) {
+        if (k)
+            r = mipsu_jobs_stats(v, k, w, n);
+        else
+            mipsu_stats_add(w, n, s);
+    }
+
+    mipsu_stream_close(&t);
+
+    for (i = 0; i < k; ++i)
+        mipsu_stats_merge(s, &v[i].s);
+    free(v);
+
+    if (r) return r;
+
+    return t.rest ? MIPSU_RESULT_SKIPPED : MIPSU_RESULT_OK;
+}
+
+static mipsu_result_t mipsu_text_stats(mipsu_stats_t* s, mipsu_cli_t c) {
+    char           l[1024];
+    mipsu_word_t   w[mipsu_stats_words];
+    size_t         n = 0;
+    bool_t         k = false;
+    mipsu_result_t r;
+
+    while (fgets(l, sizeof(l), c.f)) {
+
+        l[strcspn(l, "\n")] = 0;
+
+        r = mipsu_parse_word(l, w + n);
+
+        if (r) {
+            if (mipsu_get_flag(c, MIPSU_FLAG_STRICT)) return r;
+            mipsu_wrnrv(r, l, c);
+            k = true;
+            continue;
+        }
+
+        if (++n == mipsu_stats_words) {
+            mipsu_stats_add(w, n, s);
+            n = 0;
+        }
+    }
+
+    mipsu_stats_add(w, n, s);
+
+    return k ? MIPSU_RESULT_SKIPPED : MIPSU_RESULT_OK;
+}
+
+/* with --profile, blocks and their jumps carry the counts of a run */
+static mipsu_result_t mipsu_file_cfg(mipsu_cli_t c) {
+    mipsu_prof_t   p;
+    mipsu_result_t r;
+
+    if (!c.prof) return mipsu_cfg_words(false, NULL, c);
+
+    r = mipsu_prof_load(&p, c.prof);
+    if (r) return r;
+
+    r = mipsu_cfg_words(false, &p, c);
+    mipsu_prof_free(&p);
+
+    return r;
+}
+
+static mipsu_result_t mipsu_file_timing(mipsu_cli_t c) {
+    mipsu_cfg_t    g;
+    mipsu_map_t    t;
+    mipsu_word_t*  w;
+    mipsu_result_t r;
+    size_t         n;
+
+    memset(&g, 0, sizeof(mipsu_cfg_t));
+
+    r = mipsu_load_words(&w, &n, &t, c);
+    if (!r) r = mipsu_check_words(w, n, c);
+    if (!r) r = mipsu_cfg_build(&g, w, n, mipsu_text_base);
+    if (!r) mipsu_dump_timing(&g, c);
+
+    mipsu_cfg_free(&g);
+    mipsu_unload_words(w, t);
+
+    return r;
+}
+
+static mipsu_result_t mipsu_file_stats(mipsu_cli_t c) {
+    mipsu_stats_t  s;
+    mipsu_result_t r;
+
+    memset(&s, 0, sizeof(mipsu_stats_t));
+
+    if (mipsu_get_flag(c, MIPSU_FLAG_RAW))
+        r = mipsu_raw_stats(&s, c);
+    else
+        r = mipsu_text_stats(&s, c);
+
+    if (!r || r == MIPSU_RESULT_SKIPPED) mipsu_dump_stats(&s, c);
+
+    return r;
+}
+
+/* the bytes of a loadable segment, NULL for ones the emulator cannot hold */
+static const uint8_t* mipsu_elf_seg(const mipsu_elf_t* e, size_t i,
+                                    mipsu_elf_phdr_t* p) {
+    mipsu_elf_phdr(e, i, p);
+
+    if (p->type != mipsu_elf_pt_load || p->vaddr < mipsu_text_base ||
+        p->filesz > p->memsz || p->memsz > UINT32_MAX - p->vaddr)
+        return NULL;
+
+    return mipsu_elf_at(e, p->off, p->filesz);
+}
+
+/* copies n bytes from b to guest address a, mapping pages as it goes */
+static mipsu_result_t mipsu_emu_copy(mipsu_cpu_t* m, uint32_t a,
+                                     const uint8_t* b, uint32_t n) {
+    uint32_t k;
+    uint8_t* p;
+
+    for (; n; a += k, b += k, n -= k) {
+        k = mipsu_page_size - (a & (mipsu_page_size - 1));
+        if (k > n) k = n;
+
+        p = mipsu_page(&m->mem, a, NULL);
+        if (!p) return MIPSU_RESULT_BUFF_OVERFLOW;
+
+        memcpy(p + (a & (mipsu_page_size - 1)), b, k);
+    }
+
+    return MIPSU_RESULT_OK;
+}
+
+/* turns the whole words of a to a + n, mapped by mipsu_emu_copy, around */
+static void mipsu_emu_swap(mipsu_cpu_t* m, uint32_t a, uint32_t n) {
+    uint32_t e = a + n, w;
+    uint8_t* p;
+
+    for (a = (a + 3) & ~(uint32_t)3; a < e && e - a >= mipsu_word_size;
+         a += mipsu_word_size) {
+        p = mipsu_page(&m->mem, a, NULL) + (a & (mipsu_page_size - 1));
+
+        memcpy(&w, p, mipsu_word_size);
+        w = mipsu_swap(w);
+        memcpy(p, &w, mipsu_word_size);
+    }
+}
+
+/*
+ * Text runs from 0x00400000 to the end of the first executable segment.
+ * When the file lays that range out page aligned, as the segment's own
+ * alignment usually makes it, it is mapped in place; otherwise it is
+ * copied, with the gap before the segment zeroed. Other segments are
+ * copied, their bss left to the zeroed pages. Memory is in host order, so
+ * the words of opposite order data are swapped, like text: words load
+ * right, but halfwords, bytes and syscall strings see them in host order.
+ */
+static mipsu_result_t mipsu_elf_load(mipsu_cpu_t* m, const mipsu_elf_t* e,
+                                     mipsu_cli_t c) {
+    mipsu_elf_phdr_t   p;
+    const uint8_t*     b = NULL;
+    const mipsu_sym_t* g;
+    mipsu_word_t*      w;
+    mipsu_result_t     r;
+    uint32_t           d = 0, o;
+    bool_t             z;
+    size_t             i;
+
+    for (i = 0; i < e->h.phnum && !b; ++i) {
+        b = mipsu_elf_seg(e, i, &p);
+        d = p.vaddr - mipsu_text_base;
+
+        if (!(p.flags & mipsu_elf_pf_x) || (d | p.filesz) & 3) b = NULL;
+    }
+
+    if (!b) return MIPSU_RESULT_ELF_TEXT;
+
+    /* swapping in place must leave the program headers still to be read */
+    o = p.off + p.filesz;
+    z = !((p.off - d) & (mipsu_page_size - 1)) && p.off >= d &&
+        !(e->swap && e->h.phoff < o &&
+          p.off < e->h.phoff + (uint32_t)e->h.phnum * e->h.phentsize);
+
+    if (z) {
+        if (!mipsu_elf_words(e, p.off, p.filesz)) return MIPSU_RESULT_BAD_ELF;
+
+        r = mipsu_emu_init(m, (const mipsu_word_t*)(b - d),
+                           (d + p.filesz) / mipsu_word_size, true, NULL, c);
+    } else {
+        w = calloc(1, d + p.filesz + 1);
+        if (!w) return MIPSU_RESULT_BUFF_OVERFLOW;
+
+        memcpy((uint8_t*)w + d, b, p.filesz);
+        if (e->swap)
+            mipsu_swap_words(w + d / mipsu_word_size,
+                             p.filesz / mipsu_word_size);
+
+        r = mipsu_emu_init(m, w, (d + p.filesz) / mipsu_word_size, false,
+                           NULL, c);
+        free(w);
+    }
+
+    if (r) return r;
+
+    for (i = 0; i < e->h.phnum; ++i) {
+        b = mipsu_elf_seg(e, i, &p);
+
+        if (!b || p.flags & mipsu_elf_pf_x) continue;
+
+        r = mipsu_emu_copy(m, p.vaddr, b, p.filesz);
+        if (r) return r;
+
+        if (e->swap) mipsu_emu_swap(m, p.vaddr, p.filesz);
+    }
+
+    /* an entry point outside text could only trap on its first fetch */
+    if (e->h.entry - mipsu_text_base >= m->text || e->h.entry & 3)
+        return MIPSU_RESULT_BAD_ELF;
+
+    m->pc  = e->h.entry;
+    m->npc = m->pc + mipsu_word_size;
+
+    if ((g = mipsu_sym_named(e, "_gp"))) m->r[mipsu_reg_gp] = g->addr;
+
+    return MIPSU_RESULT_OK;
+}
+
+/* raw text, from a file or a pipe, is mapped whole and run in place */
+static mipsu_result_t mipsu_load_run(mipsu_cpu_t* m, mipsu_map_t* t,
+                                     mipsu_cli_t c) {
+    mipsu_elf_t    e;
+    mipsu_snap_t   s;
+    mipsu_word_t*  w;
+    size_t         n;
+    mipsu_result_t r;
+
+    /* the snapshot's pages are lent from the mapping, its page list copied */
+    if (mipsu_get_flag(c, MIPSU_FLAG_RESUME)) {
+        r = mipsu_snap_load(c.f, &s);
+        if (!r) r = mipsu_emu_resume(m, &s, c);
+
+        *t = s.map;
+        mipsu_snap_free(&s);
+
+        return r;
+    }
+
+    /* the mapping outlives the run, the symbols do not */
+    if (mipsu_get_flag(c, MIPSU_FLAG_ELF)) {
+        r = mipsu_elf_open(c.f, &e);
+        if (!r) r = mipsu_elf_load(m, &e, c);
+
+        *t         = e.map;
+        e.map.data = NULL;
+        mipsu_elf_close(&e);
+
+        return r;
+    }
+
+    if (!mipsu_get_flag(c, MIPSU_FLAG_RAW)) {
+        r = mipsu_read_words(&w, &n, c);
+        if (!r) r = mipsu_emu_init(m, w, n, false, NULL, c);
+        free(w);
+        return r;
+    }
+
+    r = mipsu_map_whole(t, c);
+    if (r) return r;
+
+    n = t->size;
+    r = mipsu_emu_init(m, t->data, n / mipsu_word_size, true, NULL, c);
+    if (r) return r;
+
+    if (n % mipsu_word_size) mipsu_wrnr(MIPSU_RESULT_SKIPPED, c);
+
+    return MIPSU_RESULT_OK;
+}
+
+/* like mipsu_load_run, decoded once ahead for every run of it to copy */
+static mipsu_result_t mipsu_image_load(mipsu_image_t* g, const char* s,
+                                       mipsu_cli_t c) {
+    bool_t z = mipsu_get_flag(c, MIPSU_FLAG_STRICT);
+    size_t i;
+
+    memset(g, 0, sizeof(mipsu_image_t));
+
+    if (!(c.f = fopen(s, "r"))) return g->res = MIPSU_RESULT_OPEN_FILE;
+
+    if (mipsu_get_flag(c, MIPSU_FLAG_RESUME)) {
+        g->res = mipsu_snap_load(c.f, &g->snap);
+        fclose(c.f);
+        return g->res;
+    }
+
+    if (mipsu_get_flag(c, MIPSU_FLAG_RAW)) {
+        g->res = mipsu_map_whole(&g->t, c);
+        g->w   = (mipsu_word_t*)g->t.data;
+        g->n   = g->t.size / mipsu_word_size;
+    } else
+        g->res = mipsu_read_words(&g->w, &g->n, c);
+
+    fclose(c.f);
+
+    if (!g->res && !(g->pre = malloc((g->n + 1) * sizeof(mipsu_pre_t))))
+        g->res = MIPSU_RESULT_BUFF_OVERFLOW;
+
+    for (i = 0; !g->res && i < g->n; ++i)
+        g->pre[i] = mipsu_predecode(g->w[i], z);
 
-static void mipsu_dump_field(mipsu_word_t w, mipsu_field_t f, mipsu_ctx_t c) {
-    mipsu_fmt_field(w, f, mipsu_chr_buff, c);
-    fputs(mipsu_chr_buff, c.o);
+    return g->res;
 }
 
-static void mipsu_dump_word(mipsu_word_t w, mipsu_ctx_t c) {
-    if (mipsu_get_flag(c, MIPSU_FLAG_RAW))
-        fwrite(&w, mipsu_word_size, 1, c.o);
+static void mipsu_image_free(mipsu_image_t* g) {
+    if (g->snap.map.data) mipsu_unmap(g->snap.map);
+    mipsu_snap_free(&g->snap);
+
+    if (g->t.data)
+        mipsu_unmap(g->t);
     else
-        fprintf(c.o, "0x%08X\n", w);
-}
+        free(g->w);
 
-static void mipsu_dump_mnem(mipsu_field_t f, mipsu_ctx_t c) {
-    mipsu_disasm(f, mipsu_chr_buff, c);
-    fputs(mipsu_chr_buff, c.o);
+    free(g->pre);
 }
 
-static void mipsu_dump_instr(mipsu_word_t w, mipsu_field_t f, mipsu_ctx_t c) {
-    mipsu_disasm(f, mipsu_chr_buff, c);
-    fprintf(c.o, "0x%08X  %s", w, mipsu_chr_buff);
+/* a case of bin, in and out per line; blank lines and # comments skipped */
+static mipsu_result_t mipsu_batch_read(mipsu_src_t* f, mipsu_pool_t* q,
+                                       mipsu_cli_t c) {
+    const char* ws = " \t\r";
+    char *      l, *e, *p, *z[3];
+    const char* a[3];
+    size_t      i, cap = 0;
+
+    for (l = f->data; l < f->data + f->size; l = e + 1) {
+        e = memchr(l, '\n', f->data + f->size - l);
+        if (!e) e = f->data + f->size;
+        *e = 0;
+
+        p = l + strspn(l, ws);
+        if (!*p || *p == '#') continue;
+
+        for (i = 0; *p && i < 3; ++i) {
+            a[i] = p;
+            z[i] = p + strcspn(p, ws);
+            p    = z[i] + strspn(z[i], ws);
+        }
+
+        if (i < 3 || *p) {
+            mipsu_wrnrv(MIPSU_RESULT_BAD_BATCH, l, c);
+            return MIPSU_RESULT_BAD_BATCH;
+        }
+
+        if (!mipsu_grow((void**)&q->v, q->n, &cap, sizeof(mipsu_case_t)))
+            return MIPSU_RESULT_BUFF_OVERFLOW;
+
+        for (i = 0; i < 3; ++i)
+            *z[i] = 0;
+
+        memset(q->v + q->n, 0, sizeof(mipsu_case_t));
+        q->v[q->n].bin   = a[0];
+        q->v[q->n].in    = a[1];
+        q->v[q->n++].out = a[2];
+    }
+
+    return MIPSU_RESULT_OK;
 }
 
-static void mipsu_dump_decoded(mipsu_word_t w, mipsu_ctx_t c) {
-    mipsu_field_t f = mipsu_decode(w);
-    mipsu_dump_field(w, f, c);
+static int mipsu_cmp_case(const void* x, const void* y) {
+    return strcmp((*(mipsu_case_t* const*)x)->bin,
+                  (*(mipsu_case_t* const*)y)->bin);
 }
 
-static void mipsu_dump_encoded(mipsu_field_t f, mipsu_ctx_t c) {
-    mipsu_word_t w = mipsu_encode(f);
+/* cases sorted by text, so each text is loaded once, however many use it */
+static mipsu_result_t mipsu_batch_load(mipsu_pool_t* q, mipsu_image_t* g,
+                                       size_t* k, mipsu_cli_t c) {
+    mipsu_case_t** o = malloc(q->n * sizeof(mipsu_case_t*) + 1);
+    size_t         i;
 
-    if (mipsu_get_flag(c, MIPSU_FLAG_QUIET))
-        mipsu_dump_word(w, c);
-    else
-        mipsu_dump_field(w, f, c);
-}
+    if (!o) return MIPSU_RESULT_BUFF_OVERFLOW;
 
-static void mipsu_dump_disasm(mipsu_word_t w, mipsu_ctx_t c) {
-    mipsu_field_t f = mipsu_decode(w);
+    for (i = 0; i < q->n; ++i)
+        o[i] = q->v + i;
 
-    if (mipsu_get_flag(c, MIPSU_FLAG_QUIET))
-        mipsu_dump_mnem(f, c);
-    else
-        mipsu_dump_instr(w, f, c);
-}
+    qsort(o, q->n, sizeof(mipsu_case_t*), mipsu_cmp_case);
 
-static void mipsu_dump_asm(mipsu_field_t f, mipsu_ctx_t c) {
-    mipsu_word_t w = mipsu_encode(f);
+    for (i = 0; i < q->n; ++i) {
+        if (!i || strcmp(o[i]->bin, o[i - 1]->bin))
+            mipsu_image_load(g + (*k)++, o[i]->bin, c);
 
-    if (mipsu_get_flag(c, MIPSU_FLAG_QUIET))
-        mipsu_dump_word(w, c);
-    else
-        mipsu_dump_instr(w, f, c);
+        o[i]->img = *k - 1;
+    }
+
+    free(o);
+
+    return MIPSU_RESULT_OK;
 }
 
-/* === Command Line Interface === */
+/* one line per case in manifest order, passes left out under -q */
+static mipsu_result_t mipsu_dump_batch(const mipsu_pool_t* q, mipsu_cli_t c) {
+    const mipsu_case_t* k;
+    uint64_t            n = 0;
+    size_t              i, z, bad = 0;
+    char*               p;
 
-static mipsu_result_t mipsu_arg_decode(const char* s, mipsu_ctx_t c) {
-    mipsu_word_t   w;
+    for (i = 0; i < q->n; ++i) {
+        k = q->v + i;
+        n += k->n;
+        bad += !!k->res;
+
+        if (!k->res && mipsu_get_flag(c, MIPSU_FLAG_QUIET)) continue;
+
+        /* cut to leave the line room for the message */
+        z = strlen(k->bin);
+        if (z > mipsu_line_max / 2) z = mipsu_line_max / 2;
+
+        p = mipsu_dump_begin(c);
+        p = mipsu_put_pad(p, k->res ? "fail" : "pass", mipsu_mnem_width);
+        p = mipsu_put_dec(p, k->code, mipsu_dec_width);
+        p = mipsu_put_cnt(p, k->n, mipsu_cnt_width);
+        p = mipsu_put_chr(p, ' ', 2);
+
+        memcpy(p, k->bin, z);
+        p += z;
+
+        if (k->res) {
+            p = mipsu_put_chr(p, ' ', 2);
+            p = mipsu_put_str(p, mipsu_res_msg_lut[k->res]);
+        }
+
+        *p++ = '\n';
+        mipsu_dump_end(p, c);
+    }
+
+    p = mipsu_dump_begin(c);
+    p = mipsu_put_str(p, "--------\n");
+    p = mipsu_put_stat(p, "runs", q->n);
+    p = mipsu_put_stat(p, "passed", q->n - bad);
+    p = mipsu_put_stat(p, "failed", bad);
+    p = mipsu_put_stat(p, "instrs", n);
+    mipsu_dump_end(p, c);
+
+    return bad ? MIPSU_RESULT_RUN_FAILED : MIPSU_RESULT_OK;
+}
+
+/* run --batch: every case of the manifest, on -j workers */
+static mipsu_result_t mipsu_file_batch(mipsu_cli_t c) {
+    mipsu_src_t    f;
+    mipsu_pool_t   q;
+    mipsu_image_t* g = NULL;
     mipsu_result_t r;
+    file_t*        m;
+    size_t         i, k = 0;
 
-    r = mipsu_parse_word(s, &w);
+    memset(&q, 0, sizeof(mipsu_pool_t));
 
+    if (!(m = fopen(c.batch, "r"))) return MIPSU_RESULT_OPEN_FILE;
+
+    r = mipsu_src_open(m, &f);
+    fclose(m);
     if (r) return r;
 
-    mipsu_dump_decoded(w, c);
+    r = mipsu_batch_read(&f, &q, c);
 
-    return MIPSU_RESULT_OK;
-}
+    if (!r && !(g = calloc(q.n + 1, sizeof(mipsu_image_t))))
+        r = MIPSU_RESULT_BUFF_OVERFLOW;
 
-static mipsu_result_t mipsu_args_encode(size_t n, const char** args,
-                                        mipsu_ctx_t c) {
+    if (!r) r = mipsu_batch_load(&q, g, &k, c);
 
-    mipsu_field_t  f;
-    mipsu_result_t r;
+    if (!r) {
+        q.imgs = g;
+        q.c    = c;
+        mipsu_pool_run(&q, c.jobs);
+        r = mipsu_dump_batch(&q, c);
+    }
 
-    r = mipsu_parse_field(n, args, &f, c);
+    for (i = 0; i < k; ++i)
+        mipsu_image_free(g + i);
 
-    if (!r) mipsu_dump_encoded(f, c);
+    free(g);
+    free(q.v);
+    mipsu_src_close(f);
 
     return r;
 }
 
-static mipsu_result_t mipsu_raw_disasm(mipsu_ctx_t c) {
-    mipsu_word_t w;
-    size_t       s, i;
+static mipsu_result_t mipsu_file_run(mipsu_cli_t c) {
+    mipsu_cpu_t    m;
+    mipsu_map_t    t = {};
+    mipsu_prof_t   p;
+    mipsu_result_t r, q = MIPSU_RESULT_OK;
+    char           v[11];
 
-    if (c.f == stdin) return MIPSU_RESULT_RAW_STDIN;
+    if (c.batch) return mipsu_file_batch(c);
 
-    fseek(c.f, 0, SEEK_END);
-    s = ftell(c.f);
-    fseek(c.f, 0, SEEK_SET);
+    memset(&m, 0, sizeof(mipsu_cpu_t));
 
-    if (s > mipsu_cp_len) return MIPSU_RESULT_BUFF_OVERFLOW;
+    r = mipsu_load_run(&m, &t, c);
 
-    i = fread(mipsu_cp_buff, 1, s, c.f);
+    if (!r) {
+        mipsu_emu_loop(&m);
+
+        r = m.res;
+        if (r) {
+            *mipsu_put_hex(v, m.cur, 8) = 0;
+            mipsu_errv("trap at", v, c);
+        }
 
-    if (i != s) return MIPSU_RESULT_READ_FILE;
+        mipsu_dump_cpu(&m, c);
 
-    for (i = 0; i < s; i += mipsu_word_size) {
-        w = *(mipsu_word_t*)(mipsu_cp_buff + i);
+        if (c.prof && !(q = mipsu_prof_build(&m, &p))) {
+            q = mipsu_prof_save(&p, c.prof);
+            mipsu_prof_free(&p);
+        }
 
-        mipsu_dump_disasm(w, c);
+        if (!r) r = q;
     }
 
-    return MIPSU_RESULT_OK;
+    mipsu_emu_free(&m);
+    if (t.data) mipsu_unmap(t);
+
+    return r;
 }
 
-static mipsu_result_t mipsu_file_disasm(mipsu_ctx_t c) {
-    mipsu_word_t   w;
-    bool_t         s = false;
+/* commands come from stdin, which the program's reads share */
+static mipsu_result_t mipsu_file_debug(mipsu_cli_t c) {
+    mipsu_cpu_t    m;
+    mipsu_map_t    t    = {};
+    bool_t         tty  = isatty(fileno(stdin));
+    bool_t         live = true;
     mipsu_result_t r;
+    char           l[MIPSU_LINE_MAX];
+    const char*    a[4];
+    size_t         n;
 
-    bool_t raw = mipsu_get_flag(c, MIPSU_FLAG_RAW);
+    /* serve requests never own stdin */
+    if (!c.o) return MIPSU_RESULT_BAD_CMD;
 
-    if (raw) return mipsu_raw_disasm(c);
+    memset(&m, 0, sizeof(mipsu_cpu_t));
 
-    while (fgets(mipsu_chr_buff, mipsu_chr_len, c.f)) {
+    r = mipsu_load_run(&m, &t, c);
 
-        *strchr(mipsu_chr_buff, '\n') = 0;
+    if (!r) mipsu_dump_list(&m, 0, c);
 
-        r = mipsu_parse_word(mipsu_chr_buff, &w);
+    while (!r) {
+        mipsu_flush(c);
+        fflush(c.o);
 
-        if (r) {
-            if (mipsu_get_flag(c, MIPSU_FLAG_STRICT)) return r;
-            mipsu_wrnrv(r, mipsu_chr_buff, c);
-            s = true;
+        if (tty) fputs("(mipsu) ", stderr);
+        if (!fgets(l, sizeof(l), stdin)) break;
+
+        if (!mipsu_split(l, a, 4, &n)) {
+            mipsu_wrnr(MIPSU_RESULT_TOO_MANY_ARGS, c);
             continue;
         }
 
-        mipsu_dump_disasm(w, c);
+        if (n && !strcmp(a[0], "q")) break;
+
+        r = mipsu_debug_cmd(&m, n, a, &live, c);
+        if (r) mipsu_wrnrv(r, a[0], c);
+
+        /* bad commands are reported, never ending the session */
+        if (r != MIPSU_RESULT_BUFF_OVERFLOW) r = MIPSU_RESULT_OK;
     }
 
-    return s ? MIPSU_RESULT_SKIPPED : MIPSU_RESULT_OK;
+    mipsu_emu_free(&m);
+    if (t.data) mipsu_unmap(t);
+
+    return r;
 }
 
-static mipsu_result_t mipsu_arg_disasm(const char* s, mipsu_ctx_t c) {
+static mipsu_result_t mipsu_arg_disasm(const char* s, mipsu_cli_t c) {
     mipsu_word_t   w;
     mipsu_result_t r;
 
+    if (mipsu_tty(c.o) && mipsu_get_flag(c, MIPSU_FLAG_BIN))
+        return MIPSU_RESULT_RAW_STDOUT;
+
+    if (mipsu_get_flag(c, MIPSU_FLAG_DIFF)) return MIPSU_RESULT_MISSING_ARGS;
+
     r = mipsu_parse_word(s, &w);
 
+    if (!r) r = mipsu_check_words(&w, 1, c);
     if (r) return r;
 
-    mipsu_dump_disasm(w, c);
+    mipsu_dump_disasm(mipsu_text_base, w, c);
 
     return MIPSU_RESULT_OK;
 }
 
+/* 'disasm --diff <old> <new>', both raw */
+static mipsu_result_t mipsu_args_disasm(size_t n, const char** args,
+                                        mipsu_cli_t c) {
+    mipsu_src_t    u, v;
+    file_t *       f, *g;
+    mipsu_result_t r = MIPSU_RESULT_OPEN_FILE;
+
+    if (!mipsu_get_flag(c, MIPSU_FLAG_DIFF)) return MIPSU_RESULT_BAD_ARGC;
+    if (n > 2) return MIPSU_RESULT_TOO_MANY_ARGS;
+
+    f = fopen(args[0], "r");
+    g = fopen(args[1], "r");
+
+    if (f && g && !(r = mipsu_src_open(f, &u))) {
+        r = mipsu_src_open(g, &v);
+        if (!r) {
+            r = mipsu_diff(&u, &v, c);
+            mipsu_src_close(v);
+        }
+        mipsu_src_close(u);
+    }
+
+    if (f) fclose(f);
+    if (g) fclose(g);
+
+    return r;
+}
+
 static mipsu_result_t mipsu_args_asm(size_t n, const char** args,
-                                     mipsu_ctx_t c) {
+                                     mipsu_cli_t c) {
     mipsu_result_t r;
     mipsu_field_t  f = {};
 
-    r = mipsu_asm(n, args, &f, c);
+    r = mipsu_asm_args(n, args, &f, mipsu_lib(c));
     if (r) return r;
 
     mipsu_dump_asm(f, c);
@@ -1359,48 +8336,147 @@ static mipsu_result_t mipsu_args_asm(size_t n, const char** args,
     return MIPSU_RESULT_OK;
 }
 
-static mipsu_result_t mipsu_arg_asm(const char* s, mipsu_ctx_t c) {
-    const char* a[4] = {};
-    size_t      n;
-
-    mipsu_result_t r = mipsu_parse_asm(s, a, &n);
+static mipsu_result_t mipsu_arg_asm(const char* s, mipsu_cli_t c) {
+    mipsu_result_t r;
+    mipsu_field_t  f;
 
+    r = mipsu_asm(s, &f, mipsu_lib(c));
     if (r) return r;
 
-    return mipsu_args_asm(n, a, c);
+    mipsu_dump_asm(f, c);
+
+    return MIPSU_RESULT_OK;
+}
+
+/* room for m tokens: their spans, the chars their ends replace, and them */
+static bool_t mipsu_lex_room(mipsu_span_t** a, char** k, const char*** v,
+                             size_t m) {
+    void* p;
+
+    if (!(p = realloc(*a, m * sizeof(mipsu_span_t)))) return false;
+    *a = p;
+
+    if (!(p = realloc(*k, m))) return false;
+    *k = p;
+
+    if (!(p = realloc((void*)*v, m * sizeof(const char*)))) return false;
+    *v = p;
+
+    return true;
 }
 
-static mipsu_result_t mipsu_file_asm(mipsu_ctx_t c) {
-    const char*    a[4] = {};
-    size_t         n;
+/*
+ * One pass over the mapped source: tokens are ended in place, and put back
+ * to quote a line that failed. A line of more tokens than there is room
+ * for, such as a long .word list, is lexed again once there is. Words are
+ * kept per section, and label references are patched from the fixup list
+ * once the whole file is read. Nothing is written before then, as a later
+ * line can change any word.
+ */
+static mipsu_result_t mipsu_file_asm(mipsu_cli_t c) {
+    mipsu_span_t*  a = NULL;
+    mipsu_span_t   l;
+    char*          k = NULL;
+    const char**   v = NULL;
     bool_t         s = false;
+    mipsu_src_t    f;
+    mipsu_lex_t    x;
+    mipsu_unit_t   u;
     mipsu_result_t r;
-    mipsu_field_t  f;
+    size_t         n, i, m = mipsu_lex_max;
+    char*          p;
 
-    if (c.o == stdout && mipsu_get_flag(c, MIPSU_FLAG_RAW))
+    if (mipsu_tty(c.o) && mipsu_get_flag(c, MIPSU_FLAG_RAW))
         return MIPSU_RESULT_RAW_STDOUT;
 
-    while (fgets(mipsu_chr_buff, mipsu_chr_len, c.f)) {
+    /* as with -o, a raw pipe carries the words alone */
+    if (mipsu_get_flag(c, MIPSU_FLAG_RAW)) mipsu_set_flag(&c, MIPSU_FLAG_QUIET);
+
+    r = mipsu_src_open(c.f, &f);
+    if (r) return r;
+
+    x.p = f.data;
+    x.e = f.data + f.size;
+
+    memset(&u, 0, sizeof(mipsu_unit_t));
+
+    if (!mipsu_lex_room(&a, &k, &v, m)) r = MIPSU_RESULT_BUFF_OVERFLOW;
+
+    for (p = x.p; !r && mipsu_lex_line(&x, &l, a, m, &n); p = x.p) {
+        if (n > m) {
+            m = n > 2 * m ? n : 2 * m;
+            x.p = p;
 
-        *strchr(mipsu_chr_buff, '\n') = 0;
+            if (!mipsu_lex_room(&a, &k, &v, m)) r = MIPSU_RESULT_BUFF_OVERFLOW;
+            continue;
+        }
+
+        l.s[l.n] = 0;
+
+        if (!n) continue;
 
-        if (!strlen(mipsu_chr_buff)) continue;
+        for (i = 0; i < n; ++i) {
+            k[i]           = a[i].s[a[i].n];
+            a[i].s[a[i].n] = 0;
+        }
 
-        r = mipsu_parse_asm(mipsu_chr_buff, a, &n);
+        r = mipsu_unit_line(&u, a, n, v, c);
 
-        if (!r) r = mipsu_asm(n, a, &f, c);
+        for (i = 0; r && i < n; ++i)
+            a[i].s[a[i].n] = k[i];
 
         if (r) {
-            if (mipsu_get_flag(c, MIPSU_FLAG_STRICT)) return r;
-            mipsu_wrnrv(r, mipsu_chr_buff, c);
+            if (mipsu_get_flag(c, MIPSU_FLAG_STRICT)) break;
+
+            mipsu_wrnrv(r, l.s, c);
             s = true;
-            continue;
+            r = MIPSU_RESULT_OK;
         }
+    }
+
+    if (!r) r = mipsu_unit_link(&u, c);
+
+    if (r == MIPSU_RESULT_OK || r == MIPSU_RESULT_SKIPPED)
+        mipsu_unit_dump(&u, c);
+
+    mipsu_unit_free(&u);
+    mipsu_src_close(f);
+
+    free(a);
+    free(k);
+    free((void*)v);
+
+    if (r == MIPSU_RESULT_OK || r == MIPSU_RESULT_SKIPPED)
+        return s || r ? MIPSU_RESULT_SKIPPED : MIPSU_RESULT_OK;
+
+    return r;
+}
+
+/* every mnemonic and register name must hash to its own entry */
+static mipsu_result_t mipsu_hash_check(mipsu_cli_t c) {
+    const mipsu_op_entry_t* e;
+    mipsu_result_t          r = MIPSU_RESULT_OK;
+    size_t                  i, k;
+
+    for (i = 0; i < 128; ++i) {
+        e = mipsu_instr_lut + i;
+        if (!e->len) continue;
+
+        k = mipsu_hash(e->mnem, e->len, mipsu_mnem_seed, mipsu_mnem_bits);
+        if (mipsu_mnem_hash_lut[k] == e) continue;
 
-        mipsu_dump_asm(f, c);
+        mipsu_wrnrv(r = MIPSU_RESULT_BAD_HASH, e->mnem, c);
     }
 
-    return s ? MIPSU_RESULT_SKIPPED : MIPSU_RESULT_OK;
+    for (i = 0; i < mipsu_regc; ++i) {
+        k = mipsu_hash(mipsu_reg_lut[i].name, strlen(mipsu_reg_lut[i].name),
+                       mipsu_reg_seed, mipsu_reg_bits);
+        if (mipsu_reg_hash_lut[k] == mipsu_reg_lut + i) continue;
+
+        mipsu_wrnrv(r = MIPSU_RESULT_BAD_HASH, mipsu_reg_lut[i].name, c);
+    }
+
+    return r;
 }
 
 static void mipsu_version() {
@@ -1424,7 +8500,7 @@ static const mipsu_cmd_t mipsu_cmdv[] = {
         "disasm",
         mipsu_file_disasm,
         mipsu_arg_disasm,
-        NULL,
+        mipsu_args_disasm,
     },
     {
         "encode",
@@ -1438,11 +8514,59 @@ static const mipsu_cmd_t mipsu_cmdv[] = {
         mipsu_arg_asm,
         mipsu_args_asm,
     },
+    {
+        "stats",
+        mipsu_file_stats,
+        NULL,
+        NULL,
+    },
+    {
+        "cfg",
+        mipsu_file_cfg,
+        NULL,
+        NULL,
+    },
+    {
+        "timing",
+        mipsu_file_timing,
+        NULL,
+        NULL,
+    },
+    {
+        "run",
+        mipsu_file_run,
+        NULL,
+        NULL,
+    },
+    {
+        "debug",
+        mipsu_file_debug,
+        NULL,
+        NULL,
+    },
+    {
+        "bench",
+        mipsu_file_bench,
+        mipsu_arg_bench,
+        NULL,
+    },
+    {
+        "corpus",
+        mipsu_file_corpus,
+        mipsu_arg_corpus,
+        NULL,
+    },
+    {
+        "sweep",
+        mipsu_file_sweep,
+        mipsu_arg_sweep,
+        NULL,
+    },
 };
 
 static const size_t mipsu_cmdc = sizeof(mipsu_cmdv) / sizeof(mipsu_cmd_t);
 
-static file_t* mipsu_open_file(const char* s, const char* m, mipsu_ctx_t c) {
+static file_t* mipsu_open_file(const char* s, const char* m, mipsu_cli_t c) {
     file_t* f = fopen(s, m);
 
     if (!f) mipsu_exitrv(MIPSU_RESULT_OPEN_FILE, s, c);
@@ -1454,7 +8578,46 @@ static bool_t mipsu_is_flag(const char* s, const char* f, char c) {
     return s[1] == '-' ? !strcmp(s + 2, f) : (!s[2] && s[1] == c);
 }
 
-static bool_t mipsu_handle_flag(const char* s, mipsu_ctx_t* c) {
+/* matches both '--name <v>' and '--name=<v>', returning <v> */
+static const char* mipsu_is_opt(int32_t argc, const char** argv, size_t* i,
+                                const char* f, char c, mipsu_cli_t ctx) {
+    const char* s = argv[*i];
+    size_t      n = strlen(f);
+
+    if (s[1] == '-' && !strncmp(s + 2, f, n) && s[2 + n] == '=')
+        return s + 3 + n;
+
+    if (!mipsu_is_flag(s, f, c)) return NULL;
+
+    if (*i + 1 >= (size_t)argc) mipsu_exitrv(MIPSU_RESULT_MISSING_ARGS, s, ctx);
+
+    return argv[++(*i)];
+}
+
+static void mipsu_parse_format(const char* s, mipsu_cli_t* c) {
+    size_t j;
+
+    for (j = 0; j < mipsu_formatc; ++j) {
+        if (strcmp(s, mipsu_format_lut[j].name)) continue;
+
+        c->flags &= ~(MIPSU_FLAG_JSONL | MIPSU_FLAG_BIN);
+        mipsu_set_flag(c, mipsu_format_lut[j].bit);
+        return;
+    }
+
+    mipsu_exitrv(MIPSU_RESULT_BAD_FORMAT, s, *c);
+}
+
+static size_t mipsu_parse_jobs(const char* s, mipsu_cli_t c) {
+    mipsu_word_t w;
+
+    if (mipsu_parse_word(s, &w) || !w || w > mipsu_job_max)
+        mipsu_exitrv(MIPSU_RESULT_BAD_JOBS, s, c);
+
+    return w;
+}
+
+static bool_t mipsu_handle_flag(const char* s, mipsu_cli_t* c) {
     mipsu_flag_entry_t e;
     size_t             j;
 
@@ -1470,11 +8633,13 @@ static bool_t mipsu_handle_flag(const char* s, mipsu_ctx_t* c) {
 }
 
 static size_t mipsu_handle_ctx(int32_t argc, const char** argv,
-                               const char** args, mipsu_ctx_t* c) {
-    size_t i, n = 0;
+                               const char** args, mipsu_cli_t* c) {
+    const char* v;
+    size_t      i, n = 0;
 
     c->o = stdout;
     c->f = stdin;
+    c->b = &mipsu_out;
 
     for (i = 1; i < (size_t)argc; ++i) {
 
@@ -1485,13 +8650,33 @@ static size_t mipsu_handle_ctx(int32_t argc, const char** argv,
 
         if (!argv[i][1]) mipsu_exitr(MIPSU_RESULT_STDIN_CHAR, *c);
 
-        if (mipsu_is_flag(argv[i], "output", 'o')) {
-            c->o = mipsu_open_file(argv[++i], "w", *c);
+        if ((v = mipsu_is_opt(argc, argv, &i, "output", 'o', *c))) {
+            c->o = mipsu_open_file(v, "w", *c);
             mipsu_set_flag(c, MIPSU_FLAG_QUIET);
             continue;
         }
-        if (mipsu_is_flag(argv[i], "file", 'f')) {
-            c->f = mipsu_open_file(argv[++i], "r", *c);
+        if ((v = mipsu_is_opt(argc, argv, &i, "file", 'f', *c))) {
+            c->f = mipsu_open_file(v, "r", *c);
+            continue;
+        }
+        if ((v = mipsu_is_opt(argc, argv, &i, "jobs", 'j', *c))) {
+            c->jobs = mipsu_parse_jobs(v, *c);
+            continue;
+        }
+        if ((v = mipsu_is_opt(argc, argv, &i, "profile", 0, *c))) {
+            c->prof = v;
+            continue;
+        }
+        if ((v = mipsu_is_opt(argc, argv, &i, "format", 0, *c))) {
+            mipsu_parse_format(v, c);
+            continue;
+        }
+        if ((v = mipsu_is_opt(argc, argv, &i, "cache", 0, *c))) {
+            c->cache = v;
+            continue;
+        }
+        if ((v = mipsu_is_opt(argc, argv, &i, "batch", 0, *c))) {
+            c->batch = v;
             continue;
         }
 
@@ -1506,8 +8691,8 @@ static size_t mipsu_handle_ctx(int32_t argc, const char** argv,
 }
 
 static mipsu_result_t mipsu_handle_cmd(size_t n, const char** args,
-                                       mipsu_cmd_t cmd, mipsu_ctx_t c) {
-    if (c.f != stdin && n) mipsu_exitr(MIPSU_RESULT_TOO_MANY_ARGS, c);
+                                       mipsu_cmd_t cmd, mipsu_cli_t c) {
+    if (c.f != stdin && n) return MIPSU_RESULT_TOO_MANY_ARGS;
 
     switch (n) {
     case 0:
@@ -1524,13 +8709,151 @@ static mipsu_result_t mipsu_handle_cmd(size_t n, const char** args,
     return MIPSU_RESULT_BAD_ARGC;
 }
 
+/* === Serving === */
+
+static char* mipsu_put_frame(char* p, mipsu_result_t r, size_t n) {
+    p    = mipsu_put_str(p, r ? "err " : "ok ");
+    p    = mipsu_put_dec(p, r, 0);
+    *p++ = ' ';
+    p    = mipsu_put_dec(p, n, 0);
+    *p++ = '\n';
+
+    return p;
+}
+
+/* 'ok 0 <n>' or 'err <code> <n>', a newline, then n bytes of payload */
+static void mipsu_dump_frame(mipsu_result_t r, mipsu_buff_t* b,
+                             mipsu_cli_t c) {
+    char* p;
+
+    if (r) {
+        p    = mipsu_put_str(b->data, mipsu_res_msg_lut[r]);
+        *p++ = '\n';
+        b->n = p - b->data;
+    }
+
+    if (c.b->cap - c.b->n < mipsu_line_max + b->n) mipsu_flush(c);
+
+    p = mipsu_put_frame(c.b->data + c.b->n, r, b->n);
+    memcpy(p, b->data, b->n);
+    mipsu_dump_end(p + b->n, c);
+}
+
+/* like mipsu_split, but a token in double quotes keeps its separators */
+static bool_t mipsu_req_split(char* b, const char** a, size_t m, size_t* n) {
+    char q;
+
+    for (*n = 0;; *b++ = 0) {
+        while (*b && mipsu_ignore(*b))
+            ++b;
+
+        if (!*b) return true;
+        if (*n == m) return false;
+
+        q = *b == '"' ? *b++ : 0;
+        a[(*n)++] = b;
+
+        while (*b && (q ? *b != q : !mipsu_ignore(*b)))
+            ++b;
+
+        if (!*b) return true;
+    }
+}
+
+/* the command is looked up first, so an unknown one fails alike bare */
+static mipsu_result_t mipsu_serve_req(char* s, mipsu_cli_t c) {
+    const char* a[mipsu_req_argc];
+    size_t      i, k, n;
+
+    if (!mipsu_req_split(s, a, mipsu_req_argc, &n))
+        return MIPSU_RESULT_TOO_MANY_ARGS;
+
+    for (i = k = 0; i < n; ++i)
+        if (a[i][0] != '-' || !mipsu_handle_flag(a[i], &c)) a[k++] = a[i];
+
+    for (i = 0; k && i < mipsu_cmdc; ++i) {
+        if (strcmp(a[0], mipsu_cmdv[i].name)) continue;
+        if (k < 2) return MIPSU_RESULT_MISSING_ARGS;
+
+        return mipsu_handle_cmd(k - 1, a + 1, mipsu_cmdv[i], c);
+    }
+
+    return MIPSU_RESULT_BAD_CMD;
+}
+
+static void mipsu_serve_line(char* s, mipsu_cli_t c) {
+    mipsu_buff_t   b = {mipsu_req_out, 0, sizeof(mipsu_req_out), 0};
+    mipsu_cli_t    q = c;
+    mipsu_result_t r;
+
+    /* requests dump into b alone, never flushing it; too long fails */
+    q.o = NULL;
+    q.b = &b;
+
+    r = mipsu_serve_req(s, q);
+    if (!r && b.lost) r = MIPSU_RESULT_BUFF_OVERFLOW;
+
+    mipsu_dump_frame(r, &b, c);
+}
+
+/*
+ * Answers one framed response per input line until EOF. Every line read by
+ * a single read(2) is answered before flushing, so pipelined batches cost a
+ * write per read, while an interactive client still sees each reply at once.
+ */
+static mipsu_result_t mipsu_serve(size_t n, mipsu_cli_t c) {
+    char*   l = mipsu_req_in;
+    char*   e;
+    size_t  i = 0, k = 0;
+    ssize_t r;
+    bool_t  skip = false;
+
+    if (n) return MIPSU_RESULT_TOO_MANY_ARGS;
+
+    while ((r = read(fileno(c.f), l + k, sizeof(mipsu_req_in) - k)) > 0) {
+
+        for (k += r; (e = memchr(l + i, '\n', k - i)); i = e + 1 - l) {
+            *e = 0;
+            if (!skip) mipsu_serve_line(l + i, c);
+            skip = false;
+        }
+
+        memmove(l, l + i, k - i);
+        k -= i;
+        i = 0;
+
+        if (k == sizeof(mipsu_req_in)) {
+            mipsu_buff_t b = {mipsu_req_out, 0, sizeof(mipsu_req_out), 0};
+
+            mipsu_dump_frame(MIPSU_RESULT_BUFF_OVERFLOW, &b, c);
+            skip = true;
+            k    = 0;
+        }
+
+        mipsu_flush(c);
+        fflush(c.o);
+    }
+
+    if (r < 0) return MIPSU_RESULT_READ_FILE;
+
+    if (k && !skip) {
+        l[k] = 0;
+        mipsu_serve_line(l, c);
+    }
+
+    return MIPSU_RESULT_OK;
+}
+
 int32_t main(int32_t argc, const char** argv) {
-    const char* args[argc];
-    size_t      i, n;
-    mipsu_ctx_t c = {};
+    const char*    args[argc];
+    size_t         i, n;
+    mipsu_cli_t    c = {};
+    mipsu_result_t r;
 
     n = mipsu_handle_ctx(argc, argv, args, &c);
 
+    if ((r = mipsu_hash_check(c))) mipsu_exitr(r, c);
+
     if (n < 1) {
         puts(mipsu_usage);
         mipsu_exitr(MIPSU_RESULT_MISSING_ARGS, c);
@@ -1540,6 +8863,8 @@ int32_t main(int32_t argc, const char** argv) {
 
     if (mipsu_is_flag(args[0], "help", 'h')) mipsu_help();
 
+    if (!strcmp(args[0], "serve")) mipsu_exitr(mipsu_serve(n - 1, c), c);
+
     for (i = 0; i < mipsu_cmdc; ++i)
         if (!strcmp(args[0], mipsu_cmdv[i].name))
             mipsu_exitr(mipsu_handle_cmd(n - 1, args + 1, mipsu_cmdv[i], c), c);
@@ -1547,3 +8872,4 @@ int32_t main(int32_t argc, const char** argv) {
     puts(mipsu_usage);
     mipsu_exitrv(MIPSU_RESULT_BAD_CMD, args[0], c);
 }
+#endif
@@ -0,0 +1,221 @@
+/*
+ * mipsu — MIPS32 utilities
+ *
+ * Public interface of libmipsu, the reentrant core of the mipsu CLI.
+ * Nothing here keeps global state, prints or exits: every call works on
+ * its arguments and reports failures as a mipsu_result_t.
+ *
+ * Author: mxwll013 (https://github.com/mxwll013)
+ * License: MIT
+ *
+ * Copyright (c) 2026 mxwll013
+ */
+
+#ifndef MIPSU_H
+#define MIPSU_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MIPSU_VERSION "1.0.1"
+
+/* smallest buffer mipsu_disasm and mipsu_fmt_field may be handed */
+#define MIPSU_LINE_MAX 256
+
+typedef uint32_t            mipsu_word_t;
+typedef enum mipsu_type     mipsu_type_t;
+typedef enum mipsu_result   mipsu_result_t;
+typedef enum mipsu_flag     mipsu_flag_t;
+typedef struct mipsu_field  mipsu_field_t;
+typedef struct mipsu_fields mipsu_fields_t;
+typedef struct mipsu_stats  mipsu_stats_t;
+typedef struct mipsu_record mipsu_record_t;
+typedef struct mipsu_ctx    mipsu_ctx_t;
+
+/* I first, so opcodes missing from the LUT decode as I-type */
+enum mipsu_type {
+    MIPSU_TYPE_I,
+    MIPSU_TYPE_R,
+    MIPSU_TYPE_J,
+};
+
+enum mipsu_result {
+    MIPSU_RESULT_OK,
+
+    MIPSU_RESULT_BAD_CMD,
+    MIPSU_RESULT_BAD_ARGC,
+    MIPSU_RESULT_MISSING_ARGS,
+    MIPSU_RESULT_TOO_MANY_ARGS,
+    MIPSU_RESULT_FROM_FILE,
+    MIPSU_RESULT_RAW_STDIN,
+    MIPSU_RESULT_RAW_STDOUT,
+    MIPSU_RESULT_STDIN_CHAR,
+    MIPSU_RESULT_BAD_JOBS,
+
+    MIPSU_RESULT_BAD_DEC,
+    MIPSU_RESULT_BAD_RADIX,
+    MIPSU_RESULT_BAD_HEX,
+    MIPSU_RESULT_MISSING_HEXITS,
+    MIPSU_RESULT_TOO_MANY_HEXITS,
+    MIPSU_RESULT_BAD_BIN,
+    MIPSU_RESULT_MISSING_BITS,
+    MIPSU_RESULT_TOO_MANY_BITS,
+    MIPSU_RESULT_BAD_OP,
+    MIPSU_RESULT_BAD_OP_FMT,
+    MIPSU_RESULT_BAD_OP_TYPE,
+    MIPSU_RESULT_BAD_INSTR,
+    MIPSU_RESULT_BAD_FN,
+    MIPSU_RESULT_BAD_REG,
+    MIPSU_RESULT_FIELD_OVERFLOW,
+    MIPSU_RESULT_FIELD_SIGN,
+    MIPSU_RESULT_SKIPPED,
+    MIPSU_RESULT_INSTR_SIZE,
+
+    MIPSU_RESULT_BUFF_OVERFLOW,
+    MIPSU_RESULT_READ_FILE,
+    MIPSU_RESULT_OPEN_FILE,
+    MIPSU_RESULT_MAP_FILE,
+
+    MIPSU_RESULT_EMU_INSTR,
+    MIPSU_RESULT_EMU_ADDR,
+    MIPSU_RESULT_EMU_PC,
+    MIPSU_RESULT_EMU_OVERFLOW,
+    MIPSU_RESULT_EMU_SYSCALL,
+    MIPSU_RESULT_EMU_BREAK,
+
+    MIPSU_RESULT_BAD_PROF,
+
+    MIPSU_RESULT_BAD_DEBUG,
+    MIPSU_RESULT_BAD_BREAK,
+    MIPSU_RESULT_TOO_MANY_WATCH,
+    MIPSU_RESULT_EMU_DONE,
+
+    MIPSU_RESULT_BAD_ELF,
+    MIPSU_RESULT_ELF_TEXT,
+
+    MIPSU_RESULT_BAD_LABEL,
+    MIPSU_RESULT_DUP_LABEL,
+    MIPSU_RESULT_BAD_DIRECTIVE,
+
+    MIPSU_RESULT_BAD_ENCODING,
+    MIPSU_RESULT_BAD_SWEEP,
+
+    MIPSU_RESULT_BAD_FORMAT,
+
+    MIPSU_RESULT_BAD_CACHE,
+
+    MIPSU_RESULT_BAD_BATCH,
+    MIPSU_RESULT_RUN_OUTPUT,
+    MIPSU_RESULT_RUN_FAILED,
+
+    MIPSU_RESULT_BAD_SNAP,
+    MIPSU_RESULT_NO_SNAP,
+
+    MIPSU_RESULT_BAD_HASH,
+};
+
+enum mipsu_flag {
+    MIPSU_FLAG_QUIET  = 1 << 0,
+    MIPSU_FLAG_NREG   = 1 << 1,
+    MIPSU_FLAG_DIMM   = 1 << 2,
+    MIPSU_FLAG_STRICT = 1 << 3,
+};
+
+struct mipsu_field {
+    mipsu_type_t type;
+    uint8_t      op;
+    union {
+
+        struct {
+            uint8_t rs, rt;
+
+            union {
+                struct {
+                    uint8_t rd, sh, fn;
+                };
+                struct {
+                    int16_t imm;
+                };
+            };
+        };
+
+        uint32_t addr;
+    };
+
+    /* set by mipsu_decode, as mipsu_verify would report the word */
+    mipsu_result_t res;
+};
+
+/*
+ * Fields of many words, one array per field. Every field is extracted
+ * whatever the word's type; arrays left NULL are skipped. bad is set for
+ * words mipsu_verify rejects.
+ */
+struct mipsu_fields {
+    uint8_t*  op;
+    uint8_t*  rs;
+    uint8_t*  rt;
+    uint8_t*  rd;
+    uint8_t*  sh;
+    uint8_t*  fn;
+    int16_t*  imm;
+    uint32_t* addr;
+    uint8_t*  bad;
+};
+
+/*
+ * Histograms over many words. instr is indexed like the instruction table,
+ * by fn for R-type words and by 64 + op otherwise; reads and writes count
+ * register operands, including the $ra written by jal. bad counts the
+ * words mipsu_verify rejects, unknown ones included.
+ */
+struct mipsu_stats {
+    uint64_t instr[128];
+    uint64_t bad;
+    uint64_t reads[32];
+    uint64_t writes[32];
+};
+
+/*
+ * A word as '--format=bin' writes it, in host byte order and padded to a
+ * fixed size, so files of them can be mapped and indexed as they are.
+ * Every field is extracted whatever the type; instr indexes the
+ * instruction table like mipsu_stats, and res is what mipsu_verify says.
+ */
+struct mipsu_record {
+    uint32_t     addr;
+    mipsu_word_t word;
+    int16_t      imm;
+    uint8_t      op, rs, rt, rd, sh, fn;
+    uint8_t      type, instr, res, pad;
+};
+
+/* the flags library calls read; zeroed gives the CLI's defaults */
+struct mipsu_ctx {
+    mipsu_flag_t flags;
+};
+
+mipsu_field_t  mipsu_decode(mipsu_word_t w);
+void           mipsu_decode_bulk(const mipsu_word_t* w, size_t n,
+                                 mipsu_fields_t f);
+void           mipsu_swap_words(mipsu_word_t* w, size_t n);
+void           mipsu_stats_add(const mipsu_word_t* w, size_t n,
+                               mipsu_stats_t* s);
+mipsu_word_t   mipsu_encode(mipsu_field_t f);
+size_t         mipsu_disasm(mipsu_word_t w, char* b, mipsu_ctx_t c);
+size_t         mipsu_fmt_field(mipsu_word_t w, mipsu_field_t f, char* b,
+                               mipsu_ctx_t c);
+mipsu_result_t mipsu_asm(const char* s, mipsu_field_t* f, mipsu_ctx_t c);
+mipsu_result_t mipsu_parse_word(const char* s, mipsu_word_t* out);
+mipsu_result_t mipsu_verify(mipsu_word_t w);
+const char*    mipsu_result_str(mipsu_result_t r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif